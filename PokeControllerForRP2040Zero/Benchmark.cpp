@@ -0,0 +1,218 @@
+/**
+ * Benchmark.cpp - 実機計測の実装
+ */
+
+#include "Benchmark.h"
+#include "Common.h"
+#include "Presets.h"
+#include "BinaryProtocol.h"
+#include "StickMath.h"
+#include <math.h>
+
+// パース計測の繰り返し回数
+static constexpr int BENCH_PARSE_ITERATIONS = 2000;
+
+// 計測に使う代表的な入力（Poke-Controller が実際に送る内容）
+static const GamepadInput bench_inputs[] = {
+  {0x0004, 0x08, 0x80, 0x80, 0x80, 0x80},
+  {0x0000, 0x08, 0x80, 0x80, 0x80, 0x80},
+  {0x0003, 0x08, 0x00, 0xFF, 0x80, 0x80},
+  {0x0002, 0x02, 0x80, 0x80, 0x80, 0x80},
+};
+static constexpr int BENCH_INPUT_COUNT = (int)(sizeof(bench_inputs) / sizeof(bench_inputs[0]));
+
+// コマンド振り分けの計測に使う行（HEX 行が大半、コマンド・未知の単語を混ぜる）
+// v1.5.0 の比較の連鎖との比較は host_bench（host/HostBench.cpp）で同じ組を使って行う
+static const char* const bench_command_mix[] = {
+  "0004 08 80 80 80 80",
+  "0000 08 80 80 80 80",
+  "0003 08 00 FF 80 80",
+  "0002 02 80 80 80 80",
+  "Key 28",
+  "Press 04",
+  "Release 04",
+  "end",
+  "mash_a",
+  "changetheyear",
+  "kbstat",
+  "api push A 100 1",
+  "report",
+  "my_preset",
+};
+static constexpr int BENCH_MIX_COUNT = (int)(sizeof(bench_command_mix) / sizeof(bench_command_mix[0]));
+
+// 比較用: v1.5 までの percent_to_value（毎回除算）
+static uint8_t legacy_percent_to_value(int percent) {
+  int value = STICK_CENTER + (percent * 127 / 100);
+  if (value < STICK_MIN) value = STICK_MIN;
+  if (value > STICK_MAX) value = STICK_MAX;
+  return (uint8_t)value;
+}
+
+// 比較用: v1.5 までの tiltLeftStick の計算（double の sin/cos）
+static void legacy_tilt(int direction_deg, double power, uint8_t* x, uint8_t* y) {
+  double rad = direction_deg * 3.14159265 / 180.0;
+  int lx = STICK_CENTER + (int)(sin(rad) * power * 127.0);
+  int ly = STICK_CENTER - (int)(cos(rad) * power * 127.0);
+  *x = (uint8_t)(lx < STICK_MIN ? STICK_MIN : (lx > STICK_MAX ? STICK_MAX : lx));
+  *y = (uint8_t)(ly < STICK_MIN ? STICK_MIN : (ly > STICK_MAX ? STICK_MAX : ly));
+}
+
+static constexpr int BENCH_STICK_ITERATIONS = 2000;
+
+// 1回あたりのクロック数
+static uint32_t cycles_per(uint32_t us, int n) {
+  return (uint32_t)((uint64_t)us * (F_CPU / 1000000) / n);
+}
+
+/**
+ * スティック計算: 従来の式と表引き版の速度比較
+ */
+static void bench_stick_math(void) {
+  volatile uint32_t sink = 0;
+  uint8_t x, y;
+
+  uint32_t start = micros();
+  for (int i = 0; i < BENCH_STICK_ITERATIONS; i++) sink += legacy_percent_to_value(i % 201 - 100);
+  uint32_t legacy_pct_us = micros() - start;
+  start = micros();
+  for (int i = 0; i < BENCH_STICK_ITERATIONS; i++) sink += percent_to_value(i % 201 - 100);
+  uint32_t table_pct_us = micros() - start;
+
+  start = micros();
+  for (int i = 0; i < BENCH_STICK_ITERATIONS; i++) {
+    legacy_tilt(i % 720 - 360, (i % 1001) / 1000.0, &x, &y);
+    sink += x + y;
+  }
+  uint32_t legacy_tilt_us = micros() - start;
+  start = micros();
+  for (int i = 0; i < BENCH_STICK_ITERATIONS; i++) {
+    stick_tilt_deg(i % 720 - 360, (uint32_t)(i % 1001), &x, &y);
+    sink += x + y;
+  }
+  uint32_t fixed_tilt_us = micros() - start;
+  start = micros();
+  for (int i = 0; i < BENCH_STICK_ITERATIONS; i++) {
+    stick_polar((uint16_t)(i * 97), 100, &x, &y);
+    sink += x + y;
+  }
+  uint32_t polar_us = micros() - start;
+
+  // 一致確認は host_bench で全範囲（0.1% 刻み）を行う
+  Serial.printf("Bench: stick percent legacy=%lu table=%lu cycles/conv\n",
+                (unsigned long)cycles_per(legacy_pct_us, BENCH_STICK_ITERATIONS),
+                (unsigned long)cycles_per(table_pct_us, BENCH_STICK_ITERATIONS));
+  Serial.printf("Bench: stick tilt legacy=%lu fixed=%lu polar=%lu cycles/conv\n",
+                (unsigned long)cycles_per(legacy_tilt_us, BENCH_STICK_ITERATIONS),
+                (unsigned long)cycles_per(fixed_tilt_us, BENCH_STICK_ITERATIONS),
+                (unsigned long)cycles_per(polar_us, BENCH_STICK_ITERATIONS));
+}
+
+// 改行→送信 の遅延集計
+static uint32_t latency_count = 0;
+static uint64_t latency_sum_us = 0;
+static uint32_t latency_max_us = 0;
+
+// プリセット精度集計（ProcessState ごと）
+typedef struct {
+  uint32_t steps;
+  int64_t  error_sum_us;
+  int32_t  error_min_us;
+  int32_t  error_max_us;
+} PresetTiming;
+
+static PresetTiming preset_timing[PRESET_USER + 1];
+
+void bench_record_report_latency(uint32_t latency_us) {
+  latency_count++;
+  latency_sum_us += latency_us;
+  if (latency_us > latency_max_us) latency_max_us = latency_us;
+}
+
+void bench_record_preset_step(uint8_t preset, uint32_t late_us) {
+  if (preset > PRESET_USER) return;
+  PresetTiming* t = &preset_timing[preset];
+  int32_t error = (int32_t)late_us;
+  if (t->steps == 0 || error < t->error_min_us) t->error_min_us = error;
+  if (t->steps == 0 || error > t->error_max_us) t->error_max_us = error;
+  t->error_sum_us += error;
+  t->steps++;
+}
+
+void run_benchmark(ProtocolParser parse, CommandMatcher match) {
+  // 計測中の gp_report 変更は元に戻す
+  switch_report_t saved = gp_report;
+
+  // HEX 行とバイナリフレームを事前に生成（改行・SYNC を含むワイヤ上のバイト数）
+  char lines[BENCH_INPUT_COUNT][32];
+  uint8_t frames[BENCH_INPUT_COUNT][BIN_FRAME_SIZE];
+  size_t hex_bytes = 0;
+  for (int i = 0; i < BENCH_INPUT_COUNT; i++) {
+    const GamepadInput* in = &bench_inputs[i];
+    hex_bytes += snprintf(lines[i], sizeof(lines[i]), "%04X %02X %02X %02X %02X %02X",
+                          in->raw_btns, in->hat, in->lx, in->ly, in->rx, in->ry) + 1;
+    encode_binary_frame(in, frames[i]);
+  }
+
+  char work[32];
+  uint32_t start = micros();
+  for (int i = 0; i < BENCH_PARSE_ITERATIONS; i++) {
+    strcpy(work, lines[i % BENCH_INPUT_COUNT]);
+    parse(work);
+  }
+  uint32_t hex_us = micros() - start;
+
+  start = micros();
+  for (int i = 0; i < BENCH_PARSE_ITERATIONS; i++) {
+    GamepadInput in;
+    if (decode_binary_frame(frames[i % BENCH_INPUT_COUNT], &in)) {
+      apply_gamepad_input(in.raw_btns, in.hat, in.lx, in.ly, in.rx, in.ry);
+    }
+  }
+  uint32_t bin_us = micros() - start;
+  gp_report = saved;
+
+  // コマンド振り分け（行頭キーワードの判定のみ。処理関数は呼ばない）
+  volatile int hits = 0;
+  start = micros();
+  for (int i = 0; i < BENCH_PARSE_ITERATIONS; i++) {
+    if (match(bench_command_mix[i % BENCH_MIX_COUNT])) hits++;
+  }
+  uint32_t table_us = micros() - start;
+
+  if (hex_us == 0) hex_us = 1;
+  if (bin_us == 0) bin_us = 1;
+  Serial.printf("Bench: parse %d lines in %lu us (%lu lines/s, %lu ns/line)\n",
+                BENCH_PARSE_ITERATIONS, (unsigned long)hex_us,
+                (unsigned long)((uint64_t)BENCH_PARSE_ITERATIONS * 1000000ULL / hex_us),
+                (unsigned long)((uint64_t)hex_us * 1000ULL / BENCH_PARSE_ITERATIONS));
+  Serial.printf("Bench: binary %d frames in %lu us (%lu frames/s, %lu ns/frame)\n",
+                BENCH_PARSE_ITERATIONS, (unsigned long)bin_us,
+                (unsigned long)((uint64_t)BENCH_PARSE_ITERATIONS * 1000000ULL / bin_us),
+                (unsigned long)((uint64_t)bin_us * 1000ULL / BENCH_PARSE_ITERATIONS));
+  Serial.printf("Bench: bytes/update hex=%u binary=%u\n",
+                (unsigned)(hex_bytes / BENCH_INPUT_COUNT), (unsigned)BIN_FRAME_SIZE);
+  Serial.printf("Bench: dispatch mix of %d table=%lu ns/line\n",
+                BENCH_MIX_COUNT,
+                (unsigned long)((uint64_t)table_us * 1000ULL / BENCH_PARSE_ITERATIONS));
+
+  bench_stick_math();
+
+  if (latency_count > 0) {
+    Serial.printf("Bench: newline->report n=%lu avg=%lu us max=%lu us\n",
+                  (unsigned long)latency_count,
+                  (unsigned long)(latency_sum_us / latency_count),
+                  (unsigned long)latency_max_us);
+  } else {
+    Serial.println("Bench: newline->report n=0");
+  }
+
+  for (int p = 0; p <= PRESET_USER; p++) {
+    const PresetTiming* t = &preset_timing[p];
+    if (t->steps == 0) continue;
+    Serial.printf("Bench: preset %d steps=%lu err avg=%ld us min=%ld us max=%ld us\n",
+                  p, (unsigned long)t->steps,
+                  (long)(t->error_sum_us / (int64_t)t->steps),
+                  (long)t->error_min_us, (long)t->error_max_us);
+  }
+}
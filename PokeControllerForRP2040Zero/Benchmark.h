@@ -0,0 +1,26 @@
+/**
+ * Benchmark.h - 実機計測（パース性能・送信遅延・プリセット精度）
+ * v1.6.0: Switch 未接続でも CDC 経由でタイミングを計測できるよう追加
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <Arduino.h>
+
+// パース対象の関数型（parse_protocol_line と同じシグネチャ）
+typedef void (*ProtocolParser)(char* line);
+
+// 行頭キーワードの判定関数型（is_command_keyword と同じシグネチャ）
+typedef bool (*CommandMatcher)(const char* line);
+
+// 入力の受信から、それを反映したレポート送信までの遅延を集計（core1 から呼ぶ）
+void bench_record_report_latency(uint32_t latency_us);
+
+// プリセットの1フェーズ終了時に呼ぶ（期限からの遅れを集計）
+void bench_record_preset_step(uint8_t preset, uint32_t late_us);
+
+// ベンチマーク実行と結果出力（CDC へ出力）
+void run_benchmark(ProtocolParser parse, CommandMatcher match);
+
+#endif // BENCHMARK_H
@@ -0,0 +1,42 @@
+/**
+ * BinaryProtocol.h - バイナリフレーム形式の Gamepad プロトコル
+ * v1.6.0: HEX文字列プロトコルと併用できる固定長フレームを追加
+ *
+ * フレーム構成（10バイト）:
+ *   [0]   SYNC (0xA5)  ... ASCII 範囲外のため HEX 行と衝突しない
+ *   [1]   LEN  (0x07)  ... ペイロード長（固定）
+ *   [2-3] buttons      ... HEXプロトコルの1語目と同じ（bit0: 右スティック, bit1: 左スティック, bit2- ボタン）, リトルエンディアン
+ *   [4]   hat
+ *   [5-8] lx, ly, rx, ry
+ *   [9]   CRC-8 (多項式 0x07, 初期値 0x00, LEN とペイロードが対象)
+ */
+
+#ifndef BINARYPROTOCOL_H
+#define BINARYPROTOCOL_H
+
+#include <Arduino.h>
+
+#define BIN_FRAME_SYNC         0xA5
+#define BIN_FRAME_PAYLOAD_LEN  7
+#define BIN_FRAME_SIZE         (BIN_FRAME_PAYLOAD_LEN + 3)
+
+// フレームから取り出した入力値（HEXプロトコルの6フィールドと同じ）
+typedef struct {
+  uint16_t raw_btns;
+  uint8_t  hat;
+  uint8_t  lx;
+  uint8_t  ly;
+  uint8_t  rx;
+  uint8_t  ry;
+} GamepadInput;
+
+// CRC-8 計算
+uint8_t bin_crc8(const uint8_t* data, size_t len);
+
+// フレーム検証・デコード（SYNC, LEN, CRC のいずれかが不正なら false）
+bool decode_binary_frame(const uint8_t* frame, GamepadInput* out);
+
+// フレーム生成（frame は BIN_FRAME_SIZE バイト以上）
+void encode_binary_frame(const GamepadInput* in, uint8_t* frame);
+
+#endif // BINARYPROTOCOL_H
@@ -0,0 +1,100 @@
+/**
+ * CommandTable.h - コマンドキーワードの完全ハッシュ表（コンパイル時生成）
+ * v1.6.0: strcmp の連鎖をやめ、行頭の単語1つのハッシュで処理関数を引く
+ *
+ * 表はコンパイル時に作られ、キーワード同士が同じスロットにならない
+ * シードを自動で探す。見つからなければ static_assert でビルドを止める。
+ * 実行時は 単語のハッシュ → スロット1回参照 → 文字列比較1回 で済む。
+ */
+
+#ifndef COMMANDTABLE_H
+#define COMMANDTABLE_H
+
+#include <Arduino.h>
+
+// シード探索の上限（表の生成はコンパイル時のみ）
+#define COMMAND_SEED_TRIES 4096
+
+// 処理関数（line は行全体、arg は表に登録した値）
+typedef void (*CommandHandler)(char* line, int arg);
+
+typedef struct {
+  const char*    keyword;
+  CommandHandler handler;
+  int            arg;
+} CommandEntry;
+
+// S はスロット数（2のべき乗、キーワード数の2倍以上を推奨）
+template <size_t N, size_t S>
+struct CommandTable {
+  static_assert((S & (S - 1)) == 0, "CommandTable slots must be a power of two");
+  static_assert(N < 128 && N <= S, "CommandTable has too many keywords");
+
+  uint32_t     seed;
+  bool         perfect;
+  int8_t       slots[S];   // エントリ番号（-1 は空き）
+  CommandEntry entries[N];
+};
+
+// 行頭の単語の長さ（空白または終端まで）
+constexpr size_t command_word_length(const char* s) {
+  size_t n = 0;
+  while (s[n] != '\0' && s[n] != ' ') n++;
+  return n;
+}
+
+// FNV-1a（シードで初期値をずらす）
+constexpr uint32_t command_hash(const char* s, size_t len, uint32_t seed) {
+  uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+  for (size_t i = 0; i < len; i++) {
+    h ^= (uint8_t)s[i];
+    h *= 16777619u;
+  }
+  return h ^ (h >> 16);
+}
+
+/**
+ * 完全ハッシュ表を生成（constexpr 変数の初期化に使う）
+ * 同じキーワードが2つあると perfect にならない
+ */
+template <size_t S, size_t N>
+constexpr CommandTable<N, S> make_command_table(const CommandEntry (&entries)[N]) {
+  CommandTable<N, S> t{};
+  for (size_t i = 0; i < N; i++) t.entries[i] = entries[i];
+
+  for (uint32_t seed = 0; seed < COMMAND_SEED_TRIES; seed++) {
+    for (size_t s = 0; s < S; s++) t.slots[s] = -1;
+    bool ok = true;
+    for (size_t i = 0; i < N && ok; i++) {
+      const char* kw = entries[i].keyword;
+      size_t idx = command_hash(kw, command_word_length(kw), seed) & (S - 1);
+      if (t.slots[idx] >= 0) ok = false;
+      else t.slots[idx] = (int8_t)i;
+    }
+    if (ok) {
+      t.seed = seed;
+      t.perfect = true;
+      return t;
+    }
+  }
+  t.perfect = false;
+  return t;
+}
+
+/**
+ * 行頭の単語に一致するエントリを返す（なければ nullptr）
+ */
+template <size_t N, size_t S>
+inline const CommandEntry* command_lookup(const CommandTable<N, S>& t, const char* line) {
+  size_t len = command_word_length(line);
+  int8_t i = t.slots[command_hash(line, len, t.seed) & (S - 1)];
+  if (i < 0) return nullptr;
+  const char* kw = t.entries[i].keyword;
+  if (strncmp(kw, line, len) != 0 || kw[len] != '\0') return nullptr;
+  return &t.entries[i];
+}
+
+// 登録済みキーワードか判定（表はメインファイルで定義）
+bool is_command_keyword(const char* line);
+
+#endif // COMMANDTABLE_H
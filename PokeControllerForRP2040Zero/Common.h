@@ -24,15 +24,6 @@ typedef struct TU_ATTR_PACKED {
   uint8_t  vendor;
 } switch_report_t;
 
-// ==========================================
-// SetCommand 構造体 - コマンド操作設定
-// ==========================================
-typedef struct {
-  uint8_t command;   // ボタンのビットマップ（BUTTON_A, BUTTON_Bなど）
-  int duration;      // 操作時間（ミリ秒）
-  int waittime;      // 操作後の待ち時間（ミリ秒）
-} SetCommand;
-
 // ==========================================
 // 外部変数宣言（メインファイルで定義）
 // ==========================================
@@ -40,6 +31,9 @@ extern Adafruit_USBD_HID usb_gamepad;
 extern Adafruit_USBD_HID usb_keyboard;
 extern switch_report_t gp_report;
 
+// v1.6.0: gp_report の変更を送信側（core1）へ渡す（ReportTx.cpp で定義）
+bool report_publish(void);
+
 // ==========================================
 // ボタン定義（ビットマップ）
 // ==========================================
@@ -89,9 +83,7 @@ extern switch_report_t gp_report;
  */
 static inline void press_button(uint16_t btn, uint16_t duration) {
   gp_report.buttons |= btn;
-  if (usb_gamepad.ready()) {
-    usb_gamepad.sendReport(0, &gp_report, sizeof(gp_report));
-  }
+  report_publish();
   delay(duration);
   gp_report.buttons &= ~btn;
 }
@@ -103,32 +95,52 @@ static inline void press_button(uint16_t btn, uint16_t duration) {
  */
 static inline void press_hat(uint8_t hat_val, uint16_t duration) {
   gp_report.hat = hat_val;
-  if (usb_gamepad.ready()) {
-    usb_gamepad.sendReport(0, &gp_report, sizeof(gp_report));
-  }
+  report_publish();
   delay(duration);
   gp_report.hat = HAT_CENTER; // 中央
 }
 
 /**
  * Gamepadレポートを送信
+ * v1.6.0: 実際の送信は core1 が行う（送信キューへ渡すのみ）
  */
 static inline void send_report(void) {
-  if (usb_gamepad.ready()) {
-    usb_gamepad.sendReport(0, &gp_report, sizeof(gp_report));
+  report_publish();
+}
+
+// v1.6.0: percent_to_value() は StickMath.h（表引き）へ移動
+
+/**
+ * PCからの入力値をレポートに反映（HEX/バイナリ/タイムライン共通）
+ * v1.6.0: 反映先を指定できるように分離（core1 のタイムライン再生で使用）
+ * @param raw_btns bit0: 右スティック有効, bit1: 左スティック有効, bit2以降: ボタン
+ * @param hat HAT値
+ * @param lx, ly 片側指定時は有効な側のスティック値
+ * @param rx, ry 両側指定時の右スティック値
+ */
+static inline void apply_gamepad_input_to(switch_report_t* report, uint16_t raw_btns, uint8_t hat,
+                                          uint8_t lx, uint8_t ly, uint8_t rx, uint8_t ry) {
+  bool use_right = raw_btns & 0x01;
+  bool use_left  = raw_btns & 0x02;
+  report->buttons = raw_btns >> 2;
+  report->hat = hat;
+
+  if (use_left && use_right) {
+    report->lx = lx; report->ly = ly;
+    report->rx = rx; report->ry = ry;
+  } else if (use_right) {
+    report->rx = lx; report->ry = ly;
+  } else if (use_left) {
+    report->lx = lx; report->ly = ly;
   }
 }
 
 /**
- * パーセント値をスティック値に変換
- * @param percent -100 ~ 100
- * @return 0 ~ 255（128が中央）
+ * PCからの入力値をgp_reportに反映
  */
-static inline uint8_t percent_to_value(int percent) {
-  int value = STICK_CENTER + (percent * 127 / 100);
-  if (value < STICK_MIN) value = STICK_MIN;
-  if (value > STICK_MAX) value = STICK_MAX;
-  return (uint8_t)value;
+static inline void apply_gamepad_input(uint16_t raw_btns, uint8_t hat,
+                                       uint8_t lx, uint8_t ly, uint8_t rx, uint8_t ry) {
+  apply_gamepad_input_to(&gp_report, raw_btns, hat, lx, ly, rx, ry);
 }
 
 #endif // COMMON_H
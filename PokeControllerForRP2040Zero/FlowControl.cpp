@@ -0,0 +1,63 @@
+/**
+ * FlowControl.cpp - フロー制御と ACK の実装
+ */
+
+#include "FlowControl.h"
+
+typedef struct {
+  bool     seen;        // 番号付きの行を受信済み
+  uint32_t next_seq;    // 次に期待する番号
+  uint32_t acked;       // ACK した数
+  uint32_t lost;        // 欠番として NAK した数
+} FlowPortState;
+
+static bool enabled = false;
+static FlowPortState ports[FLOW_PORT_COUNT];
+
+char* flow_strip_seq(char* line, bool* has_seq, uint32_t* seq) {
+  *has_seq = false;
+  if (line[0] != FLOW_SEQ_PREFIX) return line;
+  char* end;
+  unsigned long v = strtoul(&line[1], &end, 10);
+  if (end == &line[1] || (*end != ' ' && *end != '\0')) return line;
+  while (*end == ' ') end++;
+  *has_seq = true;
+  *seq = (uint32_t)v;
+  return end;
+}
+
+void flow_ack(Print& out, int port, uint32_t seq, uint32_t rx_free) {
+  if (!enabled || port < 0 || port >= FLOW_PORT_COUNT) return;
+  FlowPortState* st = &ports[port];
+  if (st->seen && seq != st->next_seq && seq - st->next_seq < 0x80000000u) {
+    // 先に進んだ番号: 間の行は届いていない（受信リングの上書きなど）
+    uint32_t missing = seq - st->next_seq;
+    out.printf("NAK %lu %lu\n", (unsigned long)st->next_seq, (unsigned long)missing);
+    st->lost += missing;
+  }
+  st->seen = true;
+  st->next_seq = seq + 1;
+  st->acked++;
+  out.printf("ACK %lu %lu\n", (unsigned long)seq, (unsigned long)rx_free);
+}
+
+bool flow_enabled(void) {
+  return enabled;
+}
+
+void parse_flow_command(const char* line) {
+  const char* sub = line[4] == ' ' ? &line[5] : "";
+  if (strcmp(sub, "on") == 0) {
+    enabled = true;
+    memset(ports, 0, sizeof(ports));   // 番号の連続性は有効化した時点から見る
+  } else if (strcmp(sub, "off") == 0) {
+    enabled = false;
+  } else if (sub[0] != '\0') {
+    Serial.println("Error: flow on|off");
+    return;
+  }
+  Serial.printf("Flow: %s cdc acked=%lu lost=%lu uart acked=%lu lost=%lu\n",
+                enabled ? "on" : "off",
+                (unsigned long)ports[0].acked, (unsigned long)ports[0].lost,
+                (unsigned long)ports[1].acked, (unsigned long)ports[1].lost);
+}
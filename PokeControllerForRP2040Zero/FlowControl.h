@@ -0,0 +1,42 @@
+/**
+ * FlowControl.h - シリアルプロトコルのクレジット方式フロー制御と ACK
+ * v1.6.0: PC が基板の処理に追いついているか分からず、
+ *         UART の受信リングがあふれると次の改行まで入力が捨てられるため追加
+ *
+ * 行頭に "@<番号> " を付けた行は、flow on の間 "ACK <番号> <空きバイト数>" を
+ * 受信したポートへ返す。PC は未 ACK のバイト数を空き以下に保てば取りこぼさずに連続送信できる。
+ * 番号の飛びを検出した場合は ACK の前に "NAK <最初の欠番> <個数>" を返す。
+ * 番号なしの行・flow off 時は従来どおり（応答なし）。
+ *
+ * 対象はテキスト行のみ。バイナリフレーム（BinaryProtocol.h）は固定長で番号を持たず、ACK も返さない。
+ * バイナリで送る PC は、番号だけの行 "@<番号>" を区切りとして挟む。受信は順に処理されるため、
+ * その ACK はそれより前に送ったフレームが全て処理済みであることと、その時点の空きを示す。
+ */
+
+#ifndef FLOWCONTROL_H
+#define FLOWCONTROL_H
+
+#include <Arduino.h>
+
+#define FLOW_SEQ_PREFIX  '@'
+#define FLOW_PORT_COUNT  2    // RxPort と同じ順（CDC, UART）
+
+/**
+ * 行頭の "@<番号> " を取り除く
+ * @return 番号以降の行（番号がなければ line をそのまま返す）
+ */
+char* flow_strip_seq(char* line, bool* has_seq, uint32_t* seq);
+
+/**
+ * 番号付きの行を処理した後に呼ぶ（flow on の時のみ応答を出力）
+ * @param out 受信したポートへの出力先
+ * @param rx_free そのポートの受信バッファの空き（バイト）
+ */
+void flow_ack(Print& out, int port, uint32_t seq, uint32_t rx_free);
+
+bool flow_enabled(void);
+
+// "flow on|off" / "flow"（状態表示）
+void parse_flow_command(const char* line);
+
+#endif // FLOWCONTROL_H
@@ -1,10 +1,48 @@
 /**
  * HighLevelAPI.cpp - 高レベルAPI実装
+ * v1.6.0: 各APIはアクションをキューに積むだけとし、
+ *         押下→保持→解放→待ち を loop() ごとに1ステップずつ進める
  */
 
 #include "HighLevelAPI.h"
 #include "Common.h"
-#include <math.h>
+#include "ReportTx.h"
+#include "Trace.h"
+#include "StickMath.h"
+
+// スティック指定ビット（HighLevelAction.stick_mask）
+#define STICK_MASK_LX  0x01
+#define STICK_MASK_LY  0x02
+#define STICK_MASK_RX  0x04
+#define STICK_MASK_RY  0x08
+
+// デフォルト押下時間（ミリ秒）
+#define DEFAULT_PUSH_MS 50
+
+// 1アクション = 押下状態を hold_ms 保持 → 解放して after_ms 待つ、を repeat 回
+typedef struct {
+  uint16_t buttons;      // 押下するボタン
+  uint8_t  hat;          // HAT値（HAT_CENTER: HAT を操作しない）
+  uint8_t  stick_mask;   // 操作するスティック軸
+  uint8_t  stick[4];     // lx, ly, rx, ry
+  uint16_t hold_ms;
+  uint16_t after_ms;
+  uint16_t repeat;
+} HighLevelAction;
+
+typedef enum {
+  ACTION_IDLE,      // 次のアクション待ち
+  ACTION_HOLD,      // 押下中
+  ACTION_AFTER,     // 解放後の待ち
+} ActionPhase;
+
+static HighLevelAction action_queue[HIGHLEVEL_QUEUE_SIZE];
+static uint8_t  action_head = 0;
+static uint8_t  action_count = 0;
+static ActionPhase action_phase = ACTION_IDLE;
+static uint32_t action_phase_ms = 0;
+static uint16_t action_done = 0;      // 現在のアクションの完了回数
+static uint32_t action_dropped = 0;   // キュー満杯で破棄した数
 
 // ボタンコマンドをビットマップに変換
 static uint16_t cmd_to_bitmap(ButtonCommand cmd) {
@@ -25,174 +63,332 @@ static uint16_t cmd_to_bitmap(ButtonCommand cmd) {
   }
 }
 
+// 8方向をスティック値に変換（方向列挙は左右共通の並び）
+static void direction_to_stick(int dir, uint8_t* x, uint8_t* y) {
+  switch (dir) {
+    case LS_UP:         *x = STICK_CENTER; *y = STICK_MIN; break;
+    case LS_UP_RIGHT:   *x = STICK_MAX; *y = STICK_MIN; break;
+    case LS_RIGHT:      *x = STICK_MAX; *y = STICK_CENTER; break;
+    case LS_DOWN_RIGHT: *x = STICK_MAX; *y = STICK_MAX; break;
+    case LS_DOWN:       *x = STICK_CENTER; *y = STICK_MAX; break;
+    case LS_DOWN_LEFT:  *x = STICK_MIN; *y = STICK_MAX; break;
+    case LS_LEFT:       *x = STICK_MIN; *y = STICK_CENTER; break;
+    case LS_UP_LEFT:    *x = STICK_MIN; *y = STICK_MIN; break;
+    case LS_CENTER:     // 中央
+    default:            *x = STICK_CENTER; *y = STICK_CENTER; break;
+  }
+}
+
+static uint16_t clamp_ms(int ms) {
+  if (ms < 0) return 0;
+  if (ms > 0xFFFF) return 0xFFFF;
+  return (uint16_t)ms;
+}
+
+// アクションをキューに積む
+static bool enqueue_action(const HighLevelAction* action) {
+  if (action->repeat == 0) return true;
+  if (action_count >= HIGHLEVEL_QUEUE_SIZE) {
+    action_dropped++;
+    return false;
+  }
+  action_queue[(action_head + action_count) % HIGHLEVEL_QUEUE_SIZE] = *action;
+  action_count++;
+  return true;
+}
+
+static void enqueue_stick(uint8_t mask, uint8_t x, uint8_t y, int hold_ms, int after_ms, int repeat) {
+  HighLevelAction a = {};
+  a.hat = HAT_CENTER;
+  a.stick_mask = mask;
+  if (mask & STICK_MASK_LX) { a.stick[0] = x; a.stick[1] = y; }
+  if (mask & STICK_MASK_RX) { a.stick[2] = x; a.stick[3] = y; }
+  a.hold_ms = clamp_ms(hold_ms);
+  a.after_ms = clamp_ms(after_ms);
+  a.repeat = clamp_ms(repeat);
+  enqueue_action(&a);
+}
+
 // ==================== 高レベルAPI実装 ====================
 
 // ボタンを押して離す（デフォルト押下時間）
 void pushButton(ButtonCommand cmd, int delay_after_pushing_msec, int loop_num) {
-  for (int i = 0; i < loop_num; i++) {
-    if (cmd >= CMD_UP && cmd <= CMD_RS_RIGHT) {
-      // スティックコマンド
-      switch (cmd) {
-        case CMD_UP:    useLeftStick(LS_UP, 50, delay_after_pushing_msec); break;
-        case CMD_DOWN:  useLeftStick(LS_DOWN, 50, delay_after_pushing_msec); break;
-        case CMD_LEFT:  useLeftStick(LS_LEFT, 50, delay_after_pushing_msec); break;
-        case CMD_RIGHT: useLeftStick(LS_RIGHT, 50, delay_after_pushing_msec); break;
-        case CMD_RS_UP:    useRightStick(RS_UP, 50, delay_after_pushing_msec); break;
-        case CMD_RS_DOWN:  useRightStick(RS_DOWN, 50, delay_after_pushing_msec); break;
-        case CMD_RS_LEFT:  useRightStick(RS_LEFT, 50, delay_after_pushing_msec); break;
-        case CMD_RS_RIGHT: useRightStick(RS_RIGHT, 50, delay_after_pushing_msec); break;
-      }
-    } else {
-      // ボタンコマンド
-      uint16_t btn = cmd_to_bitmap(cmd);
-      gp_report.buttons |= btn;
-      send_report();
-      delay(50); // デフォルト押下時間
-      gp_report.buttons &= ~btn;
-      send_report();
-      delay(delay_after_pushing_msec);
+  if (cmd >= CMD_UP && cmd <= CMD_RS_RIGHT) {
+    // スティックコマンド
+    int dir = LS_CENTER;
+    switch (cmd) {
+      case CMD_UP:    case CMD_RS_UP:    dir = LS_UP; break;
+      case CMD_DOWN:  case CMD_RS_DOWN:  dir = LS_DOWN; break;
+      case CMD_LEFT:  case CMD_RS_LEFT:  dir = LS_LEFT; break;
+      case CMD_RIGHT: case CMD_RS_RIGHT: dir = LS_RIGHT; break;
+      default: break;
     }
+    uint8_t mask = (cmd >= CMD_RS_UP) ? (STICK_MASK_RX | STICK_MASK_RY) : (STICK_MASK_LX | STICK_MASK_LY);
+    uint8_t x, y;
+    direction_to_stick(dir, &x, &y);
+    enqueue_stick(mask, x, y, DEFAULT_PUSH_MS, delay_after_pushing_msec, loop_num);
+  } else {
+    // ボタンコマンド
+    pushButton2(cmd, DEFAULT_PUSH_MS, delay_after_pushing_msec, loop_num);
   }
 }
 
 // ボタン押下時間指定版
 void pushButton2(ButtonCommand cmd, int pushing_time_msec, int delay_after_pushing_msec, int loop_num) {
-  for (int i = 0; i < loop_num; i++) {
-    if (cmd < CMD_UP || cmd > CMD_RS_RIGHT) {
-      uint16_t btn = cmd_to_bitmap(cmd);
-      gp_report.buttons |= btn;
-      send_report();
-      delay(pushing_time_msec);
-      gp_report.buttons &= ~btn;
-      send_report();
-      delay(delay_after_pushing_msec);
-    }
-  }
+  if (cmd >= CMD_UP && cmd <= CMD_RS_RIGHT) return;
+  HighLevelAction a = {};
+  a.buttons = cmd_to_bitmap(cmd);
+  a.hat = HAT_CENTER;
+  a.hold_ms = clamp_ms(pushing_time_msec);
+  a.after_ms = clamp_ms(delay_after_pushing_msec);
+  a.repeat = clamp_ms(loop_num);
+  enqueue_action(&a);
 }
 
 // HATボタンを押す
 void pushHatButton(uint8_t hat_value, int delay_after_pushing_msec, int loop_num) {
-  for (int i = 0; i < loop_num; i++) {
-    gp_report.hat = hat_value;
-    send_report();
-    delay(50);
-    gp_report.hat = 0x08;
-    send_report();
-    delay(delay_after_pushing_msec);
-  }
+  HighLevelAction a = {};
+  a.hat = hat_value;
+  a.hold_ms = DEFAULT_PUSH_MS;
+  a.after_ms = clamp_ms(delay_after_pushing_msec);
+  a.repeat = clamp_ms(loop_num);
+  enqueue_action(&a);
 }
 
 // HATボタンを押し続ける
 void pushHatButtonContinuous(uint8_t hat_value, int pushing_time_msec) {
-  gp_report.hat = hat_value;
-  send_report();
-  delay(pushing_time_msec);
-  gp_report.hat = 0x08;
-  send_report();
+  HighLevelAction a = {};
+  a.hat = hat_value;
+  a.hold_ms = clamp_ms(pushing_time_msec);
+  a.repeat = 1;
+  enqueue_action(&a);
 }
 
 // スティック傾き（パーセント指定）
 void tiltJoystick(int lx_per, int ly_per, int rx_per, int ry_per,
                   int tilt_time_msec, int delay_after_tilt_msec) {
-  gp_report.lx = percent_to_value(lx_per);
-  gp_report.ly = percent_to_value(ly_per);
-  gp_report.rx = percent_to_value(rx_per);
-  gp_report.ry = percent_to_value(ry_per);
-  
-  send_report();
-  delay(tilt_time_msec);
-  
-  // 中央に戻す
-  gp_report.lx = STICK_CENTER;
-  gp_report.ly = STICK_CENTER;
-  gp_report.rx = STICK_CENTER;
-  gp_report.ry = STICK_CENTER;
-  
-  send_report();
-  delay(delay_after_tilt_msec);
+  HighLevelAction a = {};
+  a.hat = HAT_CENTER;
+  a.stick_mask = STICK_MASK_LX | STICK_MASK_LY | STICK_MASK_RX | STICK_MASK_RY;
+  a.stick[0] = percent_to_value(lx_per);
+  a.stick[1] = percent_to_value(ly_per);
+  a.stick[2] = percent_to_value(rx_per);
+  a.stick[3] = percent_to_value(ry_per);
+  a.hold_ms = clamp_ms(tilt_time_msec);
+  a.after_ms = clamp_ms(delay_after_tilt_msec);
+  a.repeat = 1;
+  enqueue_action(&a);
 }
 
 // 左スティック傾け（8方向）
 void useLeftStick(LeftStickDirection dir, int tilt_time_msec, int delay_after_tilt_msec) {
-  int lx = STICK_CENTER, ly = STICK_CENTER;
-  
-  switch (dir) {
-    case LS_UP:         lx = STICK_CENTER; ly = STICK_MIN; break;
-    case LS_UP_RIGHT:   lx = STICK_MAX; ly = STICK_MIN; break;
-    case LS_RIGHT:      lx = STICK_MAX; ly = STICK_CENTER; break;
-    case LS_DOWN_RIGHT: lx = STICK_MAX; ly = STICK_MAX; break;
-    case LS_DOWN:       lx = STICK_CENTER; ly = STICK_MAX; break;
-    case LS_DOWN_LEFT:  lx = STICK_MIN; ly = STICK_MAX; break;
-    case LS_LEFT:       lx = STICK_MIN; ly = STICK_CENTER; break;
-    case LS_UP_LEFT:    lx = STICK_MIN; ly = STICK_MIN; break;
-    case LS_CENTER:     // 中央
-    default:            lx = STICK_CENTER; ly = STICK_CENTER; break;
-  }
-  
-  gp_report.lx = (uint8_t)lx;
-  gp_report.ly = (uint8_t)ly;
-  send_report();
-  delay(tilt_time_msec);
-  
-  gp_report.lx = STICK_CENTER;
-  gp_report.ly = STICK_CENTER;
-  send_report();
-  delay(delay_after_tilt_msec);
+  uint8_t lx, ly;
+  direction_to_stick(dir, &lx, &ly);
+  enqueue_stick(STICK_MASK_LX | STICK_MASK_LY, lx, ly, tilt_time_msec, delay_after_tilt_msec, 1);
 }
 
 // 右スティック傾け（8方向）
 void useRightStick(RightStickDirection dir, int tilt_time_msec, int delay_after_tilt_msec) {
-  int rx = STICK_CENTER, ry = STICK_CENTER;
-  
-  switch (dir) {
-    case RS_UP:         rx = STICK_CENTER; ry = STICK_MIN; break;
-    case RS_UP_RIGHT:   rx = STICK_MAX; ry = STICK_MIN; break;
-    case RS_RIGHT:      rx = STICK_MAX; ry = STICK_CENTER; break;
-    case RS_DOWN_RIGHT: rx = STICK_MAX; ry = STICK_MAX; break;
-    case RS_DOWN:       rx = STICK_CENTER; ry = STICK_MAX; break;
-    case RS_DOWN_LEFT:  rx = STICK_MIN; ry = STICK_MAX; break;
-    case RS_LEFT:       rx = STICK_MIN; ry = STICK_CENTER; break;
-    case RS_UP_LEFT:    rx = STICK_MIN; ry = STICK_MIN; break;
-    case RS_CENTER:     // 中央
-    default:            rx = STICK_CENTER; ry = STICK_CENTER; break;
-  }
-  
-  gp_report.rx = (uint8_t)rx;
-  gp_report.ry = (uint8_t)ry;
-  send_report();
-  delay(tilt_time_msec);
-  
-  gp_report.rx = STICK_CENTER;
-  gp_report.ry = STICK_CENTER;
-  send_report();
-  delay(delay_after_tilt_msec);
+  uint8_t rx, ry;
+  direction_to_stick(dir, &rx, &ry);
+  enqueue_stick(STICK_MASK_RX | STICK_MASK_RY, rx, ry, tilt_time_msec, delay_after_tilt_msec, 1);
 }
 
 // 左スティックを角度とパワーで傾ける
 void tiltLeftStick(int direction_deg, double power, int holdtime, int delaytime) {
-  // direction_deg: 0=右, 90=上, 180=左, -90=下
+  // direction_deg: 0=上, 90=右, 180=下, -90=左
   // power: 0.0 ~ 1.0 (1.0で最大傾き)
+  // v1.6.0: 0.1% 単位に丸めて整数版へ（0.1% 刻みにない値は従来の計算と最大 1 の差）
   
   if (power > 1.0) power = 1.0;
   if (power < 0.0) power = 0.0;
   
-  double rad = direction_deg * 3.14159265 / 180.0;
-  
-  int lx = STICK_CENTER + (int)(sin(rad) * power * 127.0);
-  int ly = STICK_CENTER - (int)(cos(rad) * power * 127.0); // Y軸は逆
+  tiltLeftStickPermille(direction_deg, (int)(power * STICK_POWER_FULL + 0.5), holdtime, delaytime);
+}
+
+// v1.6.0: パワーを 0.1% 単位の整数で指定する版（double を使わない）
+void tiltLeftStickPermille(int direction_deg, int power_permille, int holdtime, int delaytime) {
+  if (power_permille < 0) power_permille = 0;
   
-  if (lx < STICK_MIN) lx = STICK_MIN;
-  if (lx > STICK_MAX) lx = STICK_MAX;
-  if (ly < STICK_MIN) ly = STICK_MIN;
-  if (ly > STICK_MAX) ly = STICK_MAX;
+  uint8_t lx, ly;
+  stick_tilt_deg(direction_deg, (uint32_t)power_permille, &lx, &ly);
   
-  gp_report.lx = (uint8_t)lx;
-  gp_report.ly = (uint8_t)ly;
+  enqueue_stick(STICK_MASK_LX | STICK_MASK_LY, lx, ly, holdtime, delaytime, 1);
+}
+
+// ==================== ステップ実行 ====================
+
+// 押下状態を gp_report に反映
+static void apply_action(const HighLevelAction* a) {
+  gp_report.buttons |= a->buttons;
+  if (a->hat != HAT_CENTER) gp_report.hat = a->hat;
+  if (a->stick_mask & STICK_MASK_LX) gp_report.lx = a->stick[0];
+  if (a->stick_mask & STICK_MASK_LY) gp_report.ly = a->stick[1];
+  if (a->stick_mask & STICK_MASK_RX) gp_report.rx = a->stick[2];
+  if (a->stick_mask & STICK_MASK_RY) gp_report.ry = a->stick[3];
+  report_mark_source(TRACE_SRC_API);
   send_report();
-  delay(holdtime);
-  
-  gp_report.lx = STICK_CENTER;
-  gp_report.ly = STICK_CENTER;
+}
+
+// 解放（操作した部分のみ中央・非押下に戻す）
+static void release_action(const HighLevelAction* a) {
+  gp_report.buttons &= ~a->buttons;
+  if (a->hat != HAT_CENTER) gp_report.hat = HAT_CENTER;
+  if (a->stick_mask & STICK_MASK_LX) gp_report.lx = STICK_CENTER;
+  if (a->stick_mask & STICK_MASK_LY) gp_report.ly = STICK_CENTER;
+  if (a->stick_mask & STICK_MASK_RX) gp_report.rx = STICK_CENTER;
+  if (a->stick_mask & STICK_MASK_RY) gp_report.ry = STICK_CENTER;
+  report_mark_source(TRACE_SRC_API);
   send_report();
-  delay(delaytime);
+}
+
+void update_highlevel_actions(void) {
+  if (action_count == 0) return;
+  const HighLevelAction* a = &action_queue[action_head];
+  uint32_t now = millis();
+
+  switch (action_phase) {
+    case ACTION_IDLE:
+      apply_action(a);
+      action_phase = ACTION_HOLD;
+      action_phase_ms = now;
+      break;
+
+    case ACTION_HOLD:
+      if (now - action_phase_ms < a->hold_ms) return;
+      release_action(a);
+      action_phase = ACTION_AFTER;
+      // 保持時間ぶん進めた時刻を基準にし、ループ遅延を次のフェーズへ持ち越さない
+      action_phase_ms += a->hold_ms;
+      break;
+
+    case ACTION_AFTER:
+      if (now - action_phase_ms < a->after_ms) return;
+      action_phase_ms += a->after_ms;
+      action_phase = ACTION_IDLE;
+      if (++action_done >= a->repeat) {
+        action_done = 0;
+        action_head = (action_head + 1) % HIGHLEVEL_QUEUE_SIZE;
+        action_count--;
+      }
+      break;
+  }
+}
+
+void stop_highlevel_actions(void) {
+  if (action_count > 0 && action_phase == ACTION_HOLD) {
+    release_action(&action_queue[action_head]);
+  }
+  action_head = 0;
+  action_count = 0;
+  action_done = 0;
+  action_phase = ACTION_IDLE;
+}
+
+uint16_t highlevel_actions_pending(void) {
+  return action_count;
+}
+
+// ==================== シリアルコマンド ====================
+
+// ボタン名 → ButtonCommand
+static const struct {
+  const char* name;
+  ButtonCommand cmd;
+} api_button_names[] = {
+  {"UP", CMD_UP}, {"DOWN", CMD_DOWN}, {"LEFT", CMD_LEFT}, {"RIGHT", CMD_RIGHT},
+  {"RS_UP", CMD_RS_UP}, {"RS_DOWN", CMD_RS_DOWN}, {"RS_LEFT", CMD_RS_LEFT}, {"RS_RIGHT", CMD_RS_RIGHT},
+  {"A", CMD_A}, {"B", CMD_B}, {"X", CMD_X}, {"Y", CMD_Y},
+  {"L", CMD_L}, {"R", CMD_R}, {"ZL", CMD_ZL}, {"ZR", CMD_ZR},
+  {"PLUS", CMD_PLUS}, {"MINUS", CMD_MINUS}, {"HOME", CMD_HOME}, {"CAPTURE", CMD_CAPTURE},
+};
+
+// 方向名（LeftStickDirection / RightStickDirection の並び）
+static const char* const api_direction_names[] = {
+  "CENTER", "UP", "UP_RIGHT", "RIGHT", "DOWN_RIGHT", "DOWN", "DOWN_LEFT", "LEFT", "UP_LEFT",
+};
+
+static bool lookup_button(const char* name, ButtonCommand* out) {
+  for (size_t i = 0; i < sizeof(api_button_names) / sizeof(api_button_names[0]); i++) {
+    if (strcasecmp(name, api_button_names[i].name) == 0) {
+      *out = api_button_names[i].cmd;
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool lookup_direction(const char* name, int* out) {
+  for (int i = 0; i < (int)(sizeof(api_direction_names) / sizeof(api_direction_names[0])); i++) {
+    if (strcasecmp(name, api_direction_names[i]) == 0) {
+      *out = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * "api <操作> <引数...>"
+ *   api push  <ボタン> <待ち> <回数>
+ *   api push2 <ボタン> <押下時間> <待ち> <回数>
+ *   api hat   <HAT値> <待ち> <回数>
+ *   api hatc  <HAT値> <押下時間>
+ *   api tilt  <lx%> <ly%> <rx%> <ry%> <傾け時間> <待ち>
+ *   api ls    <方向> <傾け時間> <待ち>
+ *   api rs    <方向> <傾け時間> <待ち>
+ *   api lsdeg <角度> <パワー%> <傾け時間> <待ち>
+ *   api stop
+ *   api          （残りアクション数を表示）
+ */
+bool parse_api_command(const char* line) {
+  if (strncmp(line, "api", 3) != 0 || (line[3] != '\0' && line[3] != ' ')) return false;
+
+  char op[8] = "";
+  char name[12] = "";
+  int a1 = 0, a2 = 0, a3 = 0, a4 = 0, a5 = 0, a6 = 0;
+  unsigned hat = 0;
+  int n = sscanf(line, "api %7s", op);
+  bool ok = true;
+
+  if (n < 1) {
+    // 状態表示のみ
+  } else if (strcmp(op, "stop") == 0) {
+    stop_highlevel_actions();
+  } else if (strcmp(op, "push") == 0) {
+    ButtonCommand cmd;
+    ok = sscanf(line, "api push %11s %d %d", name, &a1, &a2) == 3 && lookup_button(name, &cmd);
+    if (ok) pushButton(cmd, a1, a2);
+  } else if (strcmp(op, "push2") == 0) {
+    ButtonCommand cmd;
+    ok = sscanf(line, "api push2 %11s %d %d %d", name, &a1, &a2, &a3) == 4 && lookup_button(name, &cmd);
+    if (ok) pushButton2(cmd, a1, a2, a3);
+  } else if (strcmp(op, "hat") == 0) {
+    ok = sscanf(line, "api hat %x %d %d", &hat, &a2, &a3) == 3;
+    if (ok) pushHatButton((uint8_t)hat, a2, a3);
+  } else if (strcmp(op, "hatc") == 0) {
+    ok = sscanf(line, "api hatc %x %d", &hat, &a2) == 2;
+    if (ok) pushHatButtonContinuous((uint8_t)hat, a2);
+  } else if (strcmp(op, "tilt") == 0) {
+    ok = sscanf(line, "api tilt %d %d %d %d %d %d", &a1, &a2, &a3, &a4, &a5, &a6) == 6;
+    if (ok) tiltJoystick(a1, a2, a3, a4, a5, a6);
+  } else if (strcmp(op, "ls") == 0 || strcmp(op, "rs") == 0) {
+    int dir;
+    ok = sscanf(line, "api %*s %11s %d %d", name, &a1, &a2) == 3 && lookup_direction(name, &dir);
+    if (ok && op[0] == 'l') useLeftStick((LeftStickDirection)dir, a1, a2);
+    if (ok && op[0] == 'r') useRightStick((RightStickDirection)dir, a1, a2);
+  } else if (strcmp(op, "lsdeg") == 0) {
+    ok = sscanf(line, "api lsdeg %d %d %d %d", &a1, &a2, &a3, &a4) == 4;
+    if (ok) tiltLeftStickPermille(a1, a2 * 10, a3, a4);
+  } else {
+    ok = false;
+  }
+
+  if (!ok) {
+    Serial.printf("Error: invalid api command [%s]\n", line);
+  } else {
+    Serial.printf("API: pending=%u dropped=%lu\n",
+                  (unsigned)highlevel_actions_pending(), (unsigned long)action_dropped);
+  }
+  return true;
 }
@@ -1,6 +1,7 @@
 /**
  * HighLevelAPI.h - 高レベルAPI
  * v1.4.0: スティック操作・ボタン操作の高レベルAPI追加
+ * v1.6.0: delay() を使わないステップ実行方式に変更（呼び出しは即座に戻る）
  */
 
 #ifndef HIGHLEVELAPI_H
@@ -58,7 +59,11 @@ typedef enum {
   CMD_CAPTURE,   // キャプチャボタン
 } ButtonCommand;
 
+// v1.6.0: 実行待ちアクションの最大数
+#define HIGHLEVEL_QUEUE_SIZE 32
+
 // 外部関数宣言
+// 以下の操作はキューに積まれ、update_highlevel_actions() で順に実行される
 void pushButton(ButtonCommand cmd, int delay_after_pushing_msec, int loop_num);
 void pushButton2(ButtonCommand cmd, int pushing_time_msec, int delay_after_pushing_msec, int loop_num);
 void pushHatButton(uint8_t hat_value, int delay_after_pushing_msec, int loop_num);
@@ -67,6 +72,17 @@ void tiltJoystick(int lx_per, int ly_per, int rx_per, int ry_per,
                   int tilt_time_msec, int delay_after_tilt_msec);
 void useLeftStick(LeftStickDirection dir, int tilt_time_msec, int delay_after_tilt_msec);
 void useRightStick(RightStickDirection dir, int tilt_time_msec, int delay_after_tilt_msec);
+// power: 0.0 ~ 1.0。0.1% 単位に丸めるため、0.1% 刻みにない値は従来の計算とスティック値が最大 1 異なる
 void tiltLeftStick(int direction_deg, double power, int holdtime, int delaytime);
+// v1.6.0: power_permille: 0 ~ 1000（0.1% 単位）。従来の tiltLeftStick と同じ値を整数演算のみで求める
+void tiltLeftStickPermille(int direction_deg, int power_permille, int holdtime, int delaytime);
+
+// v1.6.0: ステップ実行
+void update_highlevel_actions(void);        // loop() から毎回呼ぶ
+void stop_highlevel_actions(void);          // 実行中・実行待ちを全て破棄
+uint16_t highlevel_actions_pending(void);   // 実行中を含む残りアクション数
+
+// v1.6.0: シリアルコマンド "api ..." の解析（該当しない場合 false）
+bool parse_api_command(const char* line);
 
 #endif // HIGHLEVELAPI_H
@@ -4,76 +4,762 @@
 
 #include "JapaneseKeyboard.h"
 #include "Common.h"
+#include "Trace.h"
 
+// v1.6.0: JIS 配列の位置に合わせて作り直し（英字が数字キーになり、シフト側が空だった）
 // 日本語キーボードASCII→HIDマップ（シフトなし）
 const uint8_t jp_ascii_to_hid[128] = {
-  0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  // 0x00-0x0F
-  0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  // 0x10-0x1F
-  0x2C, 0x1E, 0x34, 0x20, 0x21, 0x22, 0x24, 0x25, 0x26, 0x27, 0x33, 0x38, 0x89, 0x2A, 0x1D, 0x35, // 0x20-0x2F (スペース-スラッシュ, ￥)
-  0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x8E, 0x2D, // 0x30-0x3F (0-9, コロン, セミコロン)
-  0x2E, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2D, // 0x40-0x4F (@-O)
-  0x2E, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, // 0x50-0x5F (P-`)
-   0,    0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0,    // 0x60-0x6F (a-o)
-  0,    0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0     // 0x70-0x7F (p-DEL)
+  0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0, // 0x00-0x0F
+  0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0, // 0x10-0x1F
+  0x2C, 0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0x36, 0x2D, 0x37, 0x38, // 0x20-0x2F (スペース-スラッシュ)
+  0x27, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x34, 0x33, 0,    0,    0,    0, // 0x30-0x3F (0-9, 記号)
+  0x2F, 0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0, // 0x40-0x4F (@, A-O)
+  0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0x30, 0x87, 0x32, 0x2E, 0, // 0x50-0x5F (P-Z, 記号)
+  0,    0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12, // 0x60-0x6F (`, a-o)
+  0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0,    0,    0,    0,    0  // 0x70-0x7F (p-z, 記号)
 };
 
 // 日本語キーボードASCII→HIDマップ（シフトあり）
 const uint8_t jp_ascii_shift_to_hid[128] = {
-  0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  // 0x00-0x0F
-  0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  // 0x10-0x1F
-  0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  // 0x20-0x2F
-  0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  // 0x30-0x3F
-  0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  // 0x40-0x4F
-  0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  // 0x50-0x5F
-  0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,  // 0x60-0x6F
-  0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0   // 0x70-0x7F
+  0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0, // 0x00-0x0F
+  0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0, // 0x10-0x1F
+  0,    0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x34, 0x33, 0,    0,    0,    0, // 0x20-0x2F (スペース-スラッシュ)
+  0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0x36, 0x2D, 0x37, 0x38, // 0x30-0x3F (0-9, 記号)
+  0,    0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12, // 0x40-0x4F (@, A-O)
+  0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0,    0,    0,    0,    0x87, // 0x50-0x5F (P-Z, 記号)
+  0x2F, 0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0, // 0x60-0x6F (`, a-o)
+  0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0x30, 0x89, 0x32, 0x2E, 0  // 0x70-0x7F (p-z, 記号)
 };
 
 // ASCII文字をJISレイアウトのHIDキーコードに変換
 uint8_t jp_ascii_to_hid_key(char c, bool* need_shift) {
   *need_shift = false;
-  
-  if (c >= 32 && c < 127) {
-    // JISレイアウトでシフトが必要な文字
-    switch (c) {
-      case '!': case '"': case '#': case '$': case '%':
-      case '&': case '\'': case '(': case ')': case '*':
-      case '+': case ':': case '<': case '>': case '?':
-      case '@': case '^': case '_':
-        *need_shift = true;
-        return jp_ascii_shift_to_hid[(uint8_t)c];
-      default:
-        return jp_ascii_to_hid[(uint8_t)c];
+  if (c < 32 || c >= 127) return 0;
+  // v1.6.0: シフトが必要かはシフト側の表で判定（JIS では @ : ^ はシフトなし）
+  uint8_t shifted = jp_ascii_shift_to_hid[(uint8_t)c];
+  if (shifted != 0) {
+    *need_shift = true;
+    return shifted;
+  }
+  return jp_ascii_to_hid[(uint8_t)c];
+}
+
+// ==========================================
+// v1.6.0: かな → ローマ字（Switch のローマ字入力 IME 用）
+// ==========================================
+// かな番号: ひらがな U+3041-U+3096 は U+3040 からの差。カタカナ U+30A1-U+30F6 は同じ番号に寄せる
+// （IME にはひらがなとして入力される。カタカナは変換候補から選ぶ）
+#define KANA_NONE        0xFF
+#define KANA_SMALL_TSU   0x23     // っ
+#define KANA_NO_ROMAJI   0xFFFF
+
+typedef struct {
+  const char* kana;     // UTF-8 で1〜2文字
+  const char* romaji;
+} KanaRomaji;
+
+// 入力キー数が少ない綴りを優先（し=si, ち=ti, ふ=hu など）
+static constexpr KanaRomaji kana_romaji_entries[] = {
+  {"あ", "a"},   {"い", "i"},   {"う", "u"},   {"え", "e"},   {"お", "o"},
+  {"か", "ka"},  {"き", "ki"},  {"く", "ku"},  {"け", "ke"},  {"こ", "ko"},
+  {"さ", "sa"},  {"し", "si"},  {"す", "su"},  {"せ", "se"},  {"そ", "so"},
+  {"た", "ta"},  {"ち", "ti"},  {"つ", "tu"},  {"て", "te"},  {"と", "to"},
+  {"な", "na"},  {"に", "ni"},  {"ぬ", "nu"},  {"ね", "ne"},  {"の", "no"},
+  {"は", "ha"},  {"ひ", "hi"},  {"ふ", "hu"},  {"へ", "he"},  {"ほ", "ho"},
+  {"ま", "ma"},  {"み", "mi"},  {"む", "mu"},  {"め", "me"},  {"も", "mo"},
+  {"や", "ya"},  {"ゆ", "yu"},  {"よ", "yo"},
+  {"ら", "ra"},  {"り", "ri"},  {"る", "ru"},  {"れ", "re"},  {"ろ", "ro"},
+  {"わ", "wa"},  {"ゐ", "wi"},  {"ゑ", "we"},  {"を", "wo"},  {"ん", "nn"},
+  {"が", "ga"},  {"ぎ", "gi"},  {"ぐ", "gu"},  {"げ", "ge"},  {"ご", "go"},
+  {"ざ", "za"},  {"じ", "zi"},  {"ず", "zu"},  {"ぜ", "ze"},  {"ぞ", "zo"},
+  {"だ", "da"},  {"ぢ", "di"},  {"づ", "du"},  {"で", "de"},  {"ど", "do"},
+  {"ば", "ba"},  {"び", "bi"},  {"ぶ", "bu"},  {"べ", "be"},  {"ぼ", "bo"},
+  {"ぱ", "pa"},  {"ぴ", "pi"},  {"ぷ", "pu"},  {"ぺ", "pe"},  {"ぽ", "po"},
+  {"ぁ", "xa"},  {"ぃ", "xi"},  {"ぅ", "xu"},  {"ぇ", "xe"},  {"ぉ", "xo"},
+  {"っ", "xtu"}, {"ゃ", "xya"}, {"ゅ", "xyu"}, {"ょ", "xyo"}, {"ゎ", "xwa"},
+  {"ゔ", "vu"},  {"ゕ", "xka"}, {"ゖ", "xke"},
+  // 拗音
+  {"きゃ", "kya"}, {"きゅ", "kyu"}, {"きょ", "kyo"},
+  {"ぎゃ", "gya"}, {"ぎゅ", "gyu"}, {"ぎょ", "gyo"},
+  {"しゃ", "sya"}, {"しゅ", "syu"}, {"しょ", "syo"}, {"しぇ", "sye"},
+  {"じゃ", "ja"},  {"じゅ", "ju"},  {"じょ", "jo"},  {"じぇ", "je"},
+  {"ちゃ", "tya"}, {"ちゅ", "tyu"}, {"ちょ", "tyo"}, {"ちぇ", "tye"},
+  {"ぢゃ", "dya"}, {"ぢゅ", "dyu"}, {"ぢょ", "dyo"},
+  {"にゃ", "nya"}, {"にゅ", "nyu"}, {"にょ", "nyo"},
+  {"ひゃ", "hya"}, {"ひゅ", "hyu"}, {"ひょ", "hyo"},
+  {"びゃ", "bya"}, {"びゅ", "byu"}, {"びょ", "byo"},
+  {"ぴゃ", "pya"}, {"ぴゅ", "pyu"}, {"ぴょ", "pyo"},
+  {"みゃ", "mya"}, {"みゅ", "myu"}, {"みょ", "myo"},
+  {"りゃ", "rya"}, {"りゅ", "ryu"}, {"りょ", "ryo"},
+  // 外来語の表記
+  {"いぇ", "ye"},
+  {"うぃ", "wi"},  {"うぇ", "we"},  {"うぉ", "who"},
+  {"くぁ", "kwa"}, {"ぐぁ", "gwa"},
+  {"つぁ", "tsa"}, {"つぃ", "tsi"}, {"つぇ", "tse"}, {"つぉ", "tso"},
+  {"てぃ", "thi"}, {"てゅ", "thu"}, {"でぃ", "dhi"}, {"でゅ", "dhu"},
+  {"とぅ", "twu"}, {"どぅ", "dwu"},
+  {"ふぁ", "fa"},  {"ふぃ", "fi"},  {"ふぇ", "fe"},  {"ふぉ", "fo"},  {"ふゅ", "fyu"},
+  {"ゔぁ", "va"},  {"ゔぃ", "vi"},  {"ゔぇ", "ve"},  {"ゔぉ", "vo"},
+};
+
+// かな以外の全角記号（IME でそのまま全角になる ASCII キーへ）
+typedef struct {
+  uint16_t code;   // Unicode
+  char     ascii;
+} KanaSymbol;
+
+static const KanaSymbol kana_symbols[] = {
+  {0x3000, ' '},  // 全角スペース
+  {0x3001, ','},  // 、
+  {0x3002, '.'},  // 。
+  {0x300C, '['},  // 「
+  {0x300D, ']'},  // 」
+  {0x30FB, '/'},  // ・
+  {0x30FC, '-'},  // ー
+  {0xFF01, '!'},  // ！
+  {0xFF1F, '?'},  // ？
+};
+
+// UTF-8 の1文字を読む（*len に消費バイト数。不正な並びは1バイト進めて 0xFFFD）
+static constexpr uint32_t utf8_decode(const char* s, size_t* len) {
+  uint8_t c0 = (uint8_t)s[0];
+  if (c0 < 0x80) {
+    *len = 1;
+    return c0;
+  }
+  if ((c0 & 0xE0) == 0xC0 && ((uint8_t)s[1] & 0xC0) == 0x80) {
+    *len = 2;
+    return ((uint32_t)(c0 & 0x1F) << 6) | ((uint8_t)s[1] & 0x3F);
+  }
+  if ((c0 & 0xF0) == 0xE0 && ((uint8_t)s[1] & 0xC0) == 0x80 && ((uint8_t)s[2] & 0xC0) == 0x80) {
+    *len = 3;
+    return ((uint32_t)(c0 & 0x0F) << 12) | ((uint32_t)((uint8_t)s[1] & 0x3F) << 6) |
+           ((uint8_t)s[2] & 0x3F);
+  }
+  if ((c0 & 0xF8) == 0xF0 && ((uint8_t)s[1] & 0xC0) == 0x80 &&
+      ((uint8_t)s[2] & 0xC0) == 0x80 && ((uint8_t)s[3] & 0xC0) == 0x80) {
+    *len = 4;
+    return ((uint32_t)(c0 & 0x07) << 18) | ((uint32_t)((uint8_t)s[1] & 0x3F) << 12) |
+           ((uint32_t)((uint8_t)s[2] & 0x3F) << 6) | ((uint8_t)s[3] & 0x3F);
+  }
+  *len = 1;
+  return 0xFFFD;
+}
+
+static constexpr uint8_t kana_from_codepoint(uint32_t cp) {
+  if (cp >= 0x3041 && cp <= 0x3096) return (uint8_t)(cp - 0x3040);
+  if (cp >= 0x30A1 && cp <= 0x30F6) return (uint8_t)(cp - 0x30A0);
+  return KANA_NONE;
+}
+
+// トライの節（根はかな番号の昇順、子は根ごとに連続して並ぶ）
+typedef struct {
+  uint8_t  kana;
+  uint8_t  child_count;
+  uint16_t first_child;
+  uint16_t romaji;      // kana_trie.pool のオフセット（KANA_NO_ROMAJI: この節単独では入力しない）
+} KanaTrieNode;
+
+template <size_t N, size_t P>
+struct KanaTrie {
+  bool         valid;        // 全項目が1〜2文字のかなで、重複がない
+  uint16_t     root_count;
+  KanaTrieNode nodes[N];
+  char         pool[P];
+};
+
+// 項目を1〜2個のかな番号に分解（失敗時 false）
+static constexpr bool kana_entry_split(const KanaRomaji& e, uint8_t* first, uint8_t* second) {
+  size_t len = 0;
+  *first = kana_from_codepoint(utf8_decode(e.kana, &len));
+  if (*first == KANA_NONE) return false;
+  *second = KANA_NONE;
+  if (e.kana[len] == '\0') return true;
+  size_t len2 = 0;
+  *second = kana_from_codepoint(utf8_decode(&e.kana[len], &len2));
+  return *second != KANA_NONE && e.kana[len + len2] == '\0';
+}
+
+template <size_t E>
+constexpr size_t kana_trie_node_count(const KanaRomaji (&entries)[E]) {
+  size_t n = 0;
+  for (size_t i = 0; i < E; i++) {
+    uint8_t f = KANA_NONE, s = KANA_NONE;
+    kana_entry_split(entries[i], &f, &s);
+    if (s != KANA_NONE) n++;   // 子
+    bool seen = false;
+    for (size_t j = 0; j < i; j++) {
+      uint8_t f2 = KANA_NONE, s2 = KANA_NONE;
+      kana_entry_split(entries[j], &f2, &s2);
+      if (f2 == f) seen = true;
     }
+    if (!seen) n++;            // 根
   }
-  return 0;
+  return n;
 }
 
-// 日本語文字列入力
-void type_jp_string(const char* str) {
-  for (int i = 0; str[i] != '\0'; i++) {
+template <size_t E>
+constexpr size_t kana_trie_pool_size(const KanaRomaji (&entries)[E]) {
+  size_t n = 0;
+  for (size_t i = 0; i < E; i++) {
+    size_t len = 0;
+    while (entries[i].romaji[len] != '\0') len++;
+    n += len + 1;
+  }
+  return n;
+}
+
+template <size_t N, size_t P, size_t E>
+constexpr KanaTrie<N, P> make_kana_trie(const KanaRomaji (&entries)[E]) {
+  KanaTrie<N, P> t{};
+  t.valid = true;
+
+  uint8_t  firsts[E] = {};
+  uint8_t  seconds[E] = {};
+  uint16_t offsets[E] = {};
+  size_t pos = 0;
+  for (size_t i = 0; i < E; i++) {
+    if (!kana_entry_split(entries[i], &firsts[i], &seconds[i])) t.valid = false;
+    offsets[i] = (uint16_t)pos;
+    for (size_t k = 0; entries[i].romaji[k] != '\0'; k++) t.pool[pos++] = entries[i].romaji[k];
+    t.pool[pos++] = '\0';
+    for (size_t j = 0; j < i; j++) {
+      if (firsts[j] == firsts[i] && seconds[j] == seconds[i]) t.valid = false;
+    }
+  }
+
+  // 根（かな番号の昇順）
+  size_t n = 0;
+  for (unsigned k = 0; k < KANA_NONE; k++) {
+    bool used = false;
+    uint16_t romaji = KANA_NO_ROMAJI;
+    for (size_t i = 0; i < E; i++) {
+      if (firsts[i] != k) continue;
+      used = true;
+      if (seconds[i] == KANA_NONE) romaji = offsets[i];
+    }
+    if (!used) continue;
+    t.nodes[n].kana = (uint8_t)k;
+    t.nodes[n].romaji = romaji;
+    n++;
+  }
+  t.root_count = (uint16_t)n;
+
+  // 子（根の順に連続して配置）
+  for (size_t r = 0; r < t.root_count; r++) {
+    t.nodes[r].first_child = (uint16_t)n;
+    for (size_t i = 0; i < E; i++) {
+      if (firsts[i] != t.nodes[r].kana || seconds[i] == KANA_NONE) continue;
+      t.nodes[n].kana = seconds[i];
+      t.nodes[n].romaji = offsets[i];
+      t.nodes[r].child_count++;
+      n++;
+    }
+  }
+  if (n != N) t.valid = false;
+  return t;
+}
+
+static constexpr size_t KANA_TRIE_NODES = kana_trie_node_count(kana_romaji_entries);
+static constexpr size_t KANA_TRIE_POOL = kana_trie_pool_size(kana_romaji_entries);
+static constexpr auto kana_trie =
+    make_kana_trie<KANA_TRIE_NODES, KANA_TRIE_POOL>(kana_romaji_entries);
+static_assert(kana_trie.valid, "kana_romaji_entries has an invalid or duplicate entry");
+static_assert(sizeof(kana_trie) <= 2048, "kana trie should stay small (flash)");
+
+// 根を二分探索
+static const KanaTrieNode* kana_trie_root(uint8_t kana) {
+  int lo = 0;
+  int hi = (int)kana_trie.root_count - 1;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    uint8_t k = kana_trie.nodes[mid].kana;
+    if (k == kana) return &kana_trie.nodes[mid];
+    if (k < kana) lo = mid + 1;
+    else hi = mid - 1;
+  }
+  return nullptr;
+}
+
+/**
+ * p の位置のかな（次の文字との拗音などを含む）をローマ字に変換
+ * @param consumed 変換に使ったバイト数
+ * @return ローマ字（かなでなければ nullptr）
+ */
+static const char* kana_to_romaji(const char* p, size_t* consumed) {
+  size_t len = 0;
+  uint8_t kana = kana_from_codepoint(utf8_decode(p, &len));
+  if (kana == KANA_NONE) return nullptr;
+  const KanaTrieNode* node = kana_trie_root(kana);
+  if (node == nullptr) return nullptr;
+
+  size_t len2 = 0;
+  uint8_t next = (p[len] != '\0') ? kana_from_codepoint(utf8_decode(&p[len], &len2)) : KANA_NONE;
+  if (next != KANA_NONE) {
+    for (unsigned i = 0; i < node->child_count; i++) {
+      const KanaTrieNode* child = &kana_trie.nodes[node->first_child + i];
+      if (child->kana == next) {
+        *consumed = len + len2;
+        return &kana_trie.pool[child->romaji];
+      }
+    }
+  }
+  if (node->romaji == KANA_NO_ROMAJI) return nullptr;
+  *consumed = len;
+  return &kana_trie.pool[node->romaji];
+}
+
+// 促音（っ）の次の子音を重ねられるか（母音・n・x で始まる場合は xtu で入力）
+static bool can_double_consonant(char c) {
+  return c >= 'b' && c <= 'z' && strchr("eionux", c) == nullptr;
+}
+
+// ==========================================
+// キーストロークキュー
+// ==========================================
+typedef struct {
+  uint8_t keycode;
+  uint8_t modifier;
+} KeyStroke;
+
+typedef enum {
+  KEYQ_IDLE,       // 待機中
+  KEYQ_PRESSED,    // 押下中（押下時間待ち）
+  KEYQ_RELEASED,   // 解放済み（待ち時間）
+} KeyQueueState;
+
+// v1.6.0: 押しっぱなしのキー（6キーロールオーバー＋修飾キー）
+static uint8_t held_modifier = 0;
+static uint8_t held_keys[KEY_ROLLOVER] = {0, 0, 0, 0, 0, 0};
+
+static KeyStroke key_queue[KEY_QUEUE_SIZE];
+static uint16_t key_head = 0;
+static uint16_t key_count = 0;
+static KeyQueueState key_state = KEYQ_IDLE;
+static uint32_t key_phase_us = 0;
+static uint32_t key_typed = 0;
+static uint32_t key_dropped = 0;
+
+// v1.6.0: 入力モードとタイミング
+static KeyTypingMode typing_mode = KEY_MODE_SAFE;
+static uint16_t key_press_ms = KEY_PRESS_MS;
+static uint16_t key_gap_ms = KEY_RELEASE_MS;
+
+// v1.6.0: 入力速度（キューが空になるまでを1回として計測）
+static bool     session_active = false;
+static uint32_t session_start_us = 0;
+static uint32_t session_keys = 0;
+static uint32_t last_session_keys = 0;
+static uint32_t last_session_us = 0;
+
+// v1.6.0: 校正（遅い段階から順に KEY_CAL_PATTERN を入力する）
+static const uint8_t key_cal_levels[][2] = {   // {押下ms, 待ちms}
+  {20, 20}, {16, 12}, {12, 10}, {10, 8}, {8, 8}, {8, 4},
+  {6, 4}, {4, 4}, {4, 2}, {3, 2}, {2, 2}, {1, 1},
+};
+#define KEY_CAL_LEVELS (sizeof(key_cal_levels) / sizeof(key_cal_levels[0]))
+static bool          cal_active = false;
+static uint8_t       cal_next = 0;           // 次に入力する段階
+static KeyTypingMode cal_saved_mode = KEY_MODE_SAFE;
+static uint16_t      cal_saved_press = KEY_PRESS_MS;
+static uint16_t      cal_saved_gap = KEY_RELEASE_MS;
+
+static bool is_modifier_key(uint8_t code) {
+  return code >= KEY_MODIFIER_FIRST && code <= KEY_MODIFIER_LAST;
+}
+
+static int find_held_key(uint8_t code) {
+  for (int i = 0; i < KEY_ROLLOVER; i++) {
+    if (held_keys[i] == code) return i;
+  }
+  return -1;
+}
+
+// キュー先頭のキーを押しっぱなしのキーに重ねられるか（6キーが全て押されていると載せられない）
+static bool queue_head_fits(void) {
+  uint8_t code = key_queue[key_head].keycode;
+  return code == 0 || find_held_key(code) >= 0 || find_held_key(0) >= 0;
+}
+
+// 押しっぱなしのキーと入力中のキュー先頭を合わせたレポートを送る
+static void send_current_report(uint8_t source) {
+  uint8_t modifier = held_modifier;
+  uint8_t keys[KEY_ROLLOVER];
+  memcpy(keys, held_keys, sizeof(keys));
+  if (key_state == KEYQ_PRESSED) {
+    const KeyStroke* ks = &key_queue[key_head];
+    modifier |= ks->modifier;
+    if (ks->keycode != 0 && find_held_key(ks->keycode) < 0) {
+      for (int i = 0; i < KEY_ROLLOVER; i++) {
+        if (keys[i] == 0) {
+          keys[i] = ks->keycode;
+          break;
+        }
+      }
+    }
+  }
+
+  bool any = (modifier != 0);
+  for (int i = 0; i < KEY_ROLLOVER; i++) any = any || keys[i] != 0;
+  if (!any) {
+    send_keyboard_release(source);   // 押しっぱなしのキーも空なのでクリアしても同じ
+    return;
+  }
+  send_keyboard_report(source, modifier, keys);
+}
+
+bool keyboard_press_keys(const uint8_t* codes, int count, uint8_t source) {
+  // 空きが足りなければ何も変えない（一部だけ押された状態にしない）
+  int needed = 0;
+  for (int i = 0; i < count; i++) {
+    if (is_modifier_key(codes[i]) || codes[i] == 0 || find_held_key(codes[i]) >= 0) continue;
+    bool dup = false;
+    for (int j = 0; j < i; j++) dup = dup || codes[j] == codes[i];
+    if (!dup) needed++;
+  }
+  int free_slots = 0;
+  for (int i = 0; i < KEY_ROLLOVER; i++) free_slots += (held_keys[i] == 0);
+  if (needed > free_slots) return false;
+
+  for (int i = 0; i < count; i++) {
+    uint8_t code = codes[i];
+    if (is_modifier_key(code)) {
+      held_modifier |= (uint8_t)(1u << (code - KEY_MODIFIER_FIRST));
+    } else if (code != 0 && find_held_key(code) < 0) {
+      held_keys[find_held_key(0)] = code;
+    }
+  }
+  send_current_report(source);
+  return true;
+}
+
+void keyboard_release_keys(const uint8_t* codes, int count, uint8_t source) {
+  for (int i = 0; i < count; i++) {
+    uint8_t code = codes[i];
+    if (is_modifier_key(code)) {
+      held_modifier &= (uint8_t)~(1u << (code - KEY_MODIFIER_FIRST));
+      continue;
+    }
+    int slot = find_held_key(code);
+    if (code == 0 || slot < 0) continue;
+    // 押した順を保つため後ろを詰める
+    for (int j = slot; j < KEY_ROLLOVER - 1; j++) held_keys[j] = held_keys[j + 1];
+    held_keys[KEY_ROLLOVER - 1] = 0;
+  }
+  send_current_report(source);
+}
+
+void keyboard_get_held(uint8_t* modifier, uint8_t keys[KEY_ROLLOVER]) {
+  *modifier = held_modifier;
+  memcpy(keys, held_keys, KEY_ROLLOVER);
+}
+
+bool enqueue_key(uint8_t keycode, uint8_t modifiers) {
+  if (key_count >= KEY_QUEUE_SIZE) {
+    key_dropped++;
+    return false;
+  }
+  KeyStroke* ks = &key_queue[(key_head + key_count) % KEY_QUEUE_SIZE];
+  ks->keycode = keycode;
+  ks->modifier = modifiers;
+  key_count++;
+  return true;
+}
+
+// ASCII 文字列をキューに積む（積んだキー数。全て入る空きがなければ何も積まずに -1）
+// かな1文字分（"kya" など）を途中まで積んで別の文字にならないよう、先に空きを確認する
+static int enqueue_ascii(const char* s, size_t len) {
+  size_t needed = 0;
+  for (size_t i = 0; i < len; i++) {
     bool need_shift = false;
-    uint8_t keycode = jp_ascii_to_hid_key(str[i], &need_shift);
-    
-    if (keycode != 0) {
-      uint8_t keys[6] = {keycode, 0, 0, 0, 0, 0};
-      uint8_t modifier = need_shift ? MOD_LEFT_SHIFT : 0;
-      
-      usb_keyboard.keyboardReport(0, modifier, keys);
-      delay(20);
-      usb_keyboard.keyboardRelease(0);
-      delay(20);
+    if (jp_ascii_to_hid_key(s[i], &need_shift) != 0) needed++;
+  }
+  if (key_count + needed > KEY_QUEUE_SIZE) {
+    key_dropped += (uint32_t)needed;
+    return -1;
+  }
+  int queued = 0;
+  for (size_t i = 0; i < len; i++) {
+    bool need_shift = false;
+    uint8_t keycode = jp_ascii_to_hid_key(s[i], &need_shift);
+    if (keycode == 0) continue;
+    if (!enqueue_key(keycode, need_shift ? MOD_LEFT_SHIFT : 0)) return -1;
+    queued++;
+  }
+  return queued;
+}
+
+// 日本語文字列入力（キューに積むだけで即座に戻る）
+// v1.6.0: UTF-8 のひらがな・カタカナ・全角記号はローマ字に変換して入力する
+//         キューに入りきらない場合は、かな1文字（促音は次のかなと合わせて）の区切りで止める
+int type_jp_string(const char* str) {
+  int queued = 0;
+  const char* p = str;
+  while (*p != '\0') {
+    const char* romaji = nullptr;
+    size_t consumed = 0;
+    char symbol = 0;
+
+    uint32_t cp = utf8_decode(p, &consumed);
+    if (cp < 0x80) {
+      symbol = (char)cp;
+    } else if (kana_from_codepoint(cp) == KANA_SMALL_TSU) {
+      // 促音: 次のかなの子音を重ねる（"っか" → "kka"）
+      size_t next_len = 0;
+      const char* next = kana_to_romaji(&p[consumed], &next_len);
+      if (next != nullptr && can_double_consonant(next[0])) {
+        // 促音と次のかなは両方入る時だけ積む（子音だけを残さない）
+        size_t needed = 1 + strlen(next);
+        if (key_count + needed > KEY_QUEUE_SIZE) {
+          key_dropped += (uint32_t)needed;
+          break;
+        }
+        symbol = next[0];
+      } else {
+        romaji = kana_to_romaji(p, &consumed);
+      }
+    } else {
+      romaji = kana_to_romaji(p, &consumed);
+      if (romaji == nullptr) {
+        for (size_t i = 0; i < sizeof(kana_symbols) / sizeof(kana_symbols[0]); i++) {
+          if (kana_symbols[i].code == cp) symbol = kana_symbols[i].ascii;
+        }
+      }
+    }
+
+    int n = 0;
+    if (romaji != nullptr) n = enqueue_ascii(romaji, strlen(romaji));
+    else if (symbol != 0) n = enqueue_ascii(&symbol, 1);
+    if (n < 0) break;
+    queued += n;
+    p += consumed;
+  }
+  return queued;
+}
+
+// 1キー分の cps を 0.1 単位で返す
+static uint32_t chars_per_sec_x10(uint32_t keys, uint32_t us) {
+  return us > 0 ? (uint32_t)((uint64_t)keys * 10000000ULL / us) : 0;
+}
+
+// 校正の次の段階を始める（キューが空の時に呼ぶ）
+static void calibration_step(void) {
+  if (cal_next > 0) {
+    const uint8_t* lv = key_cal_levels[cal_next - 1];
+    uint32_t cps10 = chars_per_sec_x10(last_session_keys, last_session_us);
+    Serial.printf("Keyboard: cal level=%u press=%u ms gap=%u ms cps=%lu.%lu\n",
+                  (unsigned)(cal_next - 1), lv[0], lv[1],
+                  (unsigned long)(cps10 / 10), (unsigned long)(cps10 % 10));
+  }
+  if (cal_next >= KEY_CAL_LEVELS) {
+    cal_active = false;
+    set_key_typing_mode(cal_saved_mode, cal_saved_press, cal_saved_gap);
+    Serial.println("Keyboard: cal done (kbcal <level> to apply the fastest intact level)");
+    return;
+  }
+  const uint8_t* lv = key_cal_levels[cal_next];
+  set_key_typing_mode(KEY_MODE_FAST, lv[0], lv[1]);
+  char text[24];
+  snprintf(text, sizeof(text), "%u:" KEY_CAL_PATTERN " ", (unsigned)cal_next);
+  type_jp_string(text);
+  cal_next++;
+}
+
+// キュー処理（押下→解放→待ち を1キーずつ進める）
+// v1.6.0: fast モードでは、次のキーが別のキーで修飾キーも同じなら解放を挟まず1レポートで切り替える
+void update_keyboard_queue(void) {
+  if (cal_active && key_count == 0 && key_state == KEYQ_IDLE) {
+    calibration_step();
+  }
+
+  uint32_t now = micros();
+  switch (key_state) {
+    case KEYQ_IDLE:
+      if (key_count == 0) return;
+      if (!usb_keyboard.ready()) return;
+      if (!queue_head_fits()) return;   // 押しっぱなしのキーが離されるまで待つ（捨てずに入力済みにもしない）
+      if (!session_active) {
+        session_active = true;
+        session_start_us = now;
+        session_keys = 0;
+      }
+      // v1.6.0: 押しっぱなしのキーに重ねて押す
+      key_state = KEYQ_PRESSED;
+      send_current_report(TRACE_SRC_KEYBOARD);
+      key_phase_us = now;
+      break;
+
+    case KEYQ_PRESSED: {
+      if (now - key_phase_us < (uint32_t)key_press_ms * 1000) return;
+      if (!usb_keyboard.ready()) return;
+      KeyStroke typed = key_queue[key_head];
+      key_head = (key_head + 1) % KEY_QUEUE_SIZE;
+      key_count--;
+      key_typed++;
+      session_keys++;
+      if (typing_mode == KEY_MODE_FAST && key_count > 0 &&
+          key_queue[key_head].keycode != typed.keycode &&
+          key_queue[key_head].modifier == typed.modifier && queue_head_fits()) {
+        send_current_report(TRACE_SRC_KEYBOARD);   // 前のキーを離し、次のキーを押す
+        key_phase_us = now;
+        break;
+      }
+      key_state = KEYQ_RELEASED;
+      send_current_report(TRACE_SRC_KEYBOARD);   // 押しっぱなしのキーだけに戻す
+      key_phase_us = now;
+      break;
+    }
+
+    case KEYQ_RELEASED:
+      if (now - key_phase_us < (uint32_t)key_gap_ms * 1000) return;
+      key_state = KEYQ_IDLE;
+      if (key_count == 0) {
+        session_active = false;
+        last_session_keys = session_keys;
+        last_session_us = now - session_start_us;
+        if (!cal_active && Serial.availableForWrite() >= 16) {
+          // PC 側が入力完了を待てるよう通知（CDC が詰まっている場合は省略）
+          Serial.println("Keyboard: done");
+        }
+      }
+      break;
+  }
+}
+
+void clear_key_queue(void) {
+  bool was_pressed = (key_state == KEYQ_PRESSED);
+  key_head = 0;
+  key_count = 0;
+  key_state = KEYQ_IDLE;
+  session_active = false;
+  if (cal_active) {
+    cal_active = false;
+    set_key_typing_mode(cal_saved_mode, cal_saved_press, cal_saved_gap);
+  }
+  if (was_pressed) {
+    send_current_report(TRACE_SRC_SYSTEM);
+  }
+}
+
+void get_key_queue_status(KeyQueueStatus* status) {
+  status->queued = key_count;
+  status->typing = (key_count > 0 || key_state != KEYQ_IDLE);
+  status->typed = key_typed;
+  status->dropped = key_dropped;
+  status->last_keys = last_session_keys;
+  status->last_us = last_session_us;
+}
+
+void set_key_typing_mode(KeyTypingMode mode, uint16_t press_ms, uint16_t gap_ms) {
+  typing_mode = mode;
+  key_press_ms = press_ms;
+  key_gap_ms = gap_ms;
+}
+
+static void print_typing_mode(void) {
+  Serial.printf("Keyboard: mode=%s press=%u ms gap=%u ms\n",
+                typing_mode == KEY_MODE_FAST ? "fast" : "safe",
+                (unsigned)key_press_ms, (unsigned)key_gap_ms);
+}
+
+void parse_kbmode_command(const char* line) {
+  const char* sub = line[6] == ' ' ? &line[7] : "";
+  if (strcmp(sub, "safe") == 0) {
+    set_key_typing_mode(KEY_MODE_SAFE, KEY_PRESS_MS, KEY_RELEASE_MS);
+  } else if (strcmp(sub, "fast") == 0) {
+    set_key_typing_mode(KEY_MODE_FAST, KEY_FAST_PRESS_MS, KEY_FAST_GAP_MS);
+  } else if (strncmp(sub, "fast ", 5) == 0) {
+    char* end;
+    unsigned long press = strtoul(&sub[5], &end, 10);
+    unsigned long gap = strtoul(end, &end, 10);
+    if (*end != '\0' || press < 1 || gap < 1 || press > KEY_TIMING_MAX_MS || gap > KEY_TIMING_MAX_MS) {
+      Serial.printf("Error: kbmode fast <press 1-%u ms> <gap 1-%u ms>\n",
+                    (unsigned)KEY_TIMING_MAX_MS, (unsigned)KEY_TIMING_MAX_MS);
+      return;
     }
+    set_key_typing_mode(KEY_MODE_FAST, (uint16_t)press, (uint16_t)gap);
+  } else if (sub[0] != '\0') {
+    Serial.println("Error: kbmode safe|fast [press_ms gap_ms]");
+    return;
   }
+  print_typing_mode();
+}
+
+void parse_kbcal_command(const char* line) {
+  const char* sub = line[5] == ' ' ? &line[6] : "";
+  if (strcmp(sub, "start") == 0) {
+    if (cal_active || key_count > 0 || key_state != KEYQ_IDLE) {
+      Serial.println("Error: keyboard is busy");
+      return;
+    }
+    cal_saved_mode = typing_mode;
+    cal_saved_press = key_press_ms;
+    cal_saved_gap = key_gap_ms;
+    cal_next = 0;
+    cal_active = true;
+    Serial.printf("Keyboard: cal start levels=%u pattern=%s\n",
+                  (unsigned)KEY_CAL_LEVELS, KEY_CAL_PATTERN);
+    return;
+  }
+  if (strcmp(sub, "stop") == 0) {
+    clear_key_queue();
+    print_typing_mode();
+    return;
+  }
+  if (sub[0] == '\0') {
+    for (size_t i = 0; i < KEY_CAL_LEVELS; i++) {
+      Serial.printf("Keyboard: cal level=%u press=%u ms gap=%u ms\n",
+                    (unsigned)i, key_cal_levels[i][0], key_cal_levels[i][1]);
+    }
+    print_typing_mode();
+    return;
+  }
+  char* end;
+  unsigned long level = strtoul(sub, &end, 10);
+  if (end == sub || *end != '\0' || level >= KEY_CAL_LEVELS) {
+    Serial.printf("Error: kbcal start|stop|<0-%u>\n", (unsigned)(KEY_CAL_LEVELS - 1));
+    return;
+  }
+  set_key_typing_mode(KEY_MODE_FAST, key_cal_levels[level][0], key_cal_levels[level][1]);
+  print_typing_mode();
 }
 
 // 日本語キー押下（修飾キー対応）
-void press_jp_key(uint8_t keycode, uint8_t modifiers) {
-  uint8_t keys[6] = {keycode, 0, 0, 0, 0, 0};
-  usb_keyboard.keyboardReport(0, modifiers, keys);
+// v1.6.0: 押しっぱなしのキーに追加する。修飾キーは E0～E7 のコードとして同じ呼び出しで渡し、
+//         空きがなく押せなかった場合は修飾キーも押さない
+bool press_jp_key(uint8_t keycode, uint8_t modifiers) {
+  uint8_t codes[1 + 8];
+  int count = 0;
+  for (int bit = 0; bit < 8; bit++) {
+    if (modifiers & (1u << bit)) codes[count++] = (uint8_t)(KEY_MODIFIER_FIRST + bit);
+  }
+  codes[count++] = keycode;
+  return keyboard_press_keys(codes, count, TRACE_SRC_HEX);
 }
 
 // 全キー解放
 void release_all_jp_keys(void) {
-  usb_keyboard.keyboardRelease(0);
+  send_keyboard_release(TRACE_SRC_HEX);
+}
+
+// v1.6.0: 送信したレポートをトレースに記録
+static bool kb_pressed = false;   // 最後に送ったレポートでキーを押している
+
+// 実際に送信できたレポートだけを記録する（エンドポイントが塞がっていれば送信されない）
+bool send_keyboard_report(uint8_t source, uint8_t modifier, uint8_t keys[6]) {
+  if (!usb_keyboard.keyboardReport(0, modifier, keys)) return false;
+  trace_keyboard(source, modifier, keys);
+  kb_pressed = true;
+  return true;
+}
+
+void send_keyboard_release(uint8_t source) {
+  static const uint8_t no_keys[6] = {0, 0, 0, 0, 0, 0};
+  held_modifier = 0;
+  memset(held_keys, 0, sizeof(held_keys));
+  // 安全タイムアウト中は毎ループ解放を送るため、押下中からの解放のみ記録する
+  if (usb_keyboard.keyboardRelease(0) && kb_pressed) {
+    trace_keyboard(source, 0, no_keys);
+    kb_pressed = false;
+  }
 }
@@ -1,6 +1,7 @@
 /**
  * JapaneseKeyboard.h - 日本語キーボードレイアウト
  * v1.4.0: 日本語キーボード（JIS）対応追加
+ * v1.6.0: かな→ローマ字変換（コンパイル時生成のトライ）、ASCII→JIS 表の修正
  */
 
 #ifndef JAPANESEKEYBOARD_H
@@ -27,14 +28,71 @@
 #define MOD_RIGHT_ALT       0x40
 #define MOD_RIGHT_GUI       0x80
 
+// v1.6.0: 修飾キーの HID Usage ID（E0=左Ctrl ... E7=右GUI、ビット位置は MOD_* と同じ順）
+#define KEY_MODIFIER_FIRST  0xE0
+#define KEY_MODIFIER_LAST   0xE7
+#define KEY_ROLLOVER        6     // 同時に押せる修飾キー以外のキー数
+
 // 日本語キーボードのASCII→HIDマップ（簡易版）
 extern const uint8_t jp_ascii_to_hid[128];
 extern const uint8_t jp_ascii_shift_to_hid[128];
 
+// v1.6.0: キーストロークキュー（文字列入力・Key コマンドを非ブロッキング化）
+#define KEY_QUEUE_SIZE     256   // 1行分（RX_LINE_MAX）の文字列を保持できる段数
+#define KEY_PRESS_MS       20    // 押下時間（safe モード）
+#define KEY_RELEASE_MS     20    // 解放後の待ち時間（safe モード）
+
+// v1.6.0: 高速入力モード（同じキーの連続・シフトの切り替え時だけ解放を挟む）
+#define KEY_FAST_PRESS_MS  8     // fast モードの押下時間（既定値）
+#define KEY_FAST_GAP_MS    8     // fast モードで解放を挟む場合の待ち時間（既定値）
+#define KEY_TIMING_MAX_MS  255
+#define KEY_CAL_PATTERN    "aaAbBcc12"   // 校正用（同じキー・シフト切り替え・連続入力を含む）
+
+typedef enum {
+  KEY_MODE_SAFE = 0,   // 1キーごとに押下→解放→待ち（従来動作）
+  KEY_MODE_FAST        // 解放を省いて次のキーへ切り替える
+} KeyTypingMode;
+
+// キーボード入力状態
+typedef struct {
+  uint16_t queued;    // キュー内の未入力キー数
+  bool     typing;    // 入力中（キュー処理中）
+  uint32_t typed;     // 入力済みキー数（累計）
+  uint32_t dropped;   // キュー満杯で破棄したキー数（累計）
+  uint32_t last_keys; // v1.6.0: 直前の入力（キューが空になるまで）のキー数
+  uint32_t last_us;   // 同、所要時間
+} KeyQueueStatus;
+
 // 外部関数宣言
 uint8_t jp_ascii_to_hid_key(char c, bool* need_shift);
-void type_jp_string(const char* str);
-void press_jp_key(uint8_t keycode, uint8_t modifiers);
+// v1.6.0: UTF-8 のひらがな・カタカナはローマ字入力のキー列に変換。キューに積んだキー数を返す
+int type_jp_string(const char* str);
+bool enqueue_key(uint8_t keycode, uint8_t modifiers);
+void update_keyboard_queue(void);            // loop() から毎回呼ぶ
+void clear_key_queue(void);
+void get_key_queue_status(KeyQueueStatus* status);
+
+// v1.6.0: 入力モードとタイミング（"kbmode safe" / "kbmode fast [押下ms 待ちms]"）
+void set_key_typing_mode(KeyTypingMode mode, uint16_t press_ms, uint16_t gap_ms);
+void parse_kbmode_command(const char* line);
+// v1.6.0: タイミングの校正（"kbcal start" で段階ごとに校正用の文字列を入力、"kbcal <段階>" で適用）
+void parse_kbcal_command(const char* line);
+bool press_jp_key(uint8_t keycode, uint8_t modifiers);   // 空きがなければ false（何も押さない）
 void release_all_jp_keys(void);
 
+/**
+ * v1.6.0: 押しっぱなしのキー（Press / Release）の状態管理
+ * codes は HID Usage ID の並び（E0-E7 は修飾キーとして扱う）。変更は1つのレポートで送信する。
+ * キュー入力中のキーは押しっぱなしのキーに重ねて送る。
+ * @return keyboard_press_keys は空きが足りない場合 false（何も押さない）
+ */
+bool keyboard_press_keys(const uint8_t* codes, int count, uint8_t source);
+void keyboard_release_keys(const uint8_t* codes, int count, uint8_t source);
+void keyboard_get_held(uint8_t* modifier, uint8_t keys[KEY_ROLLOVER]);
+
+// v1.6.0: Keyboard レポート送信（送信できたらトレースに入力元と共に記録し true）
+bool send_keyboard_report(uint8_t source, uint8_t modifier, uint8_t keys[6]);
+// 全キーを離す（押しっぱなしの状態もクリア）
+void send_keyboard_release(uint8_t source);
+
 #endif // JAPANESEKEYBOARD_H
@@ -0,0 +1,81 @@
+/**
+ * LatencyStats.cpp - 遅延ヒストグラムの実装
+ */
+
+#include "LatencyStats.h"
+
+static LatencyHistogram histograms[LAT_HIST_COUNT];
+static volatile bool core1_reset_requested = false;   // core0 → core1 のリセット要求
+
+static const char* const hist_names[LAT_HIST_COUNT] = {
+  "newline->parsed",
+  "parsed->send",
+  "newline->send",
+  "loop",
+};
+
+void latency_record(LatencyHist hist, uint32_t us) {
+  LatencyHistogram* h = &histograms[hist];
+  // 最上位ビットの位置がバケット番号（0us と 1us はバケット0）
+  uint32_t bucket = 31 - __builtin_clz(us | 1);
+  if (bucket >= LAT_BUCKETS) bucket = LAT_BUCKETS - 1;
+  h->buckets[bucket]++;
+  h->count++;
+  h->sum_us += us;
+  h->sq_sum += (uint64_t)us * us;
+  if (us > h->max_us) h->max_us = us;
+}
+
+// 整数の平方根（出力時のみ使用）
+static uint32_t isqrt64(uint64_t v) {
+  uint64_t r = 0;
+  for (uint64_t bit = 1ULL << 62; bit != 0; bit >>= 2) {
+    if (v >= r + bit) {
+      v -= r + bit;
+      r = (r >> 1) + bit;
+    } else {
+      r >>= 1;
+    }
+  }
+  return (uint32_t)r;
+}
+
+void latency_print(void) {
+  for (int i = 0; i < LAT_HIST_COUNT; i++) {
+    // 出力中に書き換わっても表示が崩れないようコピーしてから出す
+    LatencyHistogram h = histograms[i];
+    if (h.count == 0) {
+      Serial.printf("Stats: %s n=0\n", hist_names[i]);
+      continue;
+    }
+    uint64_t mean = h.sum_us / h.count;
+    uint64_t sq_mean = h.sq_sum / h.count;
+    uint32_t sd = sq_mean > mean * mean ? isqrt64(sq_mean - mean * mean) : 0;
+    Serial.printf("Stats: %s n=%lu avg=%lu us sd=%lu us max=%lu us |", hist_names[i],
+                  (unsigned long)h.count, (unsigned long)mean, (unsigned long)sd,
+                  (unsigned long)h.max_us);
+    for (int b = 0; b < LAT_BUCKETS; b++) {
+      if (h.buckets[b] == 0) continue;
+      if (b == LAT_BUCKETS - 1) {
+        Serial.printf(" >=%lu:%lu", 1UL << b, (unsigned long)h.buckets[b]);
+      } else {
+        Serial.printf(" <%lu:%lu", 1UL << (b + 1), (unsigned long)h.buckets[b]);
+      }
+    }
+    Serial.println();
+  }
+}
+
+// core0 のヒストグラムはその場で消し、core1 が書き込み中のものは次の latency_core1_poll で消させる
+void latency_reset(void) {
+  memset(&histograms[LAT_NEWLINE_TO_PARSED], 0, sizeof(LatencyHistogram));
+  memset(&histograms[LAT_LOOP], 0, sizeof(LatencyHistogram));
+  core1_reset_requested = true;
+}
+
+void latency_core1_poll(void) {
+  if (!core1_reset_requested) return;
+  memset(&histograms[LAT_PARSED_TO_SEND], 0, sizeof(LatencyHistogram));
+  memset(&histograms[LAT_NEWLINE_TO_SEND], 0, sizeof(LatencyHistogram));
+  core1_reset_requested = false;
+}
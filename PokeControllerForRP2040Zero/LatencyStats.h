@@ -0,0 +1,45 @@
+/**
+ * LatencyStats.h - 遅延ヒストグラム（改行受信→解析→送信、loop() 周期）
+ * v1.6.0: PC 側で入力の取りこぼしが疑われたときに、実機の遅延分布を確認するため追加
+ *
+ * バケットは2のべき乗幅で固定（バケット i は 2^i 以上 2^(i+1) 未満 us）。
+ * 記録は加算のみで、出力は stats コマンドの要求時だけ行う。
+ * 各ヒストグラムは1つのコアだけが書き込む（core0: 解析・loop、core1: 送信）。
+ */
+
+#ifndef LATENCYSTATS_H
+#define LATENCYSTATS_H
+
+#include <Arduino.h>
+
+#define LAT_BUCKETS 16   // 最後のバケットは 32768us 以上をまとめて数える
+
+typedef enum {
+  LAT_NEWLINE_TO_PARSED = 0,  // 改行の読み出し → parse_protocol_line 完了（core0）
+  LAT_PARSED_TO_SEND,         // 解析完了 → その状態を最初に載せた sendReport（core1）
+  LAT_NEWLINE_TO_SEND,        // 改行の読み出し → sendReport（core1）
+  LAT_LOOP,                   // loop() 1周の時間（core0）
+  LAT_HIST_COUNT
+} LatencyHist;
+
+typedef struct {
+  uint32_t count;
+  uint64_t sum_us;
+  uint64_t sq_sum;    // v1.6.0: 二乗和（ばらつき = 標準偏差の計算用）
+  uint32_t max_us;
+  uint32_t buckets[LAT_BUCKETS];
+} LatencyHistogram;
+
+// 1件記録（割り込み禁止なし・数命令）
+void latency_record(LatencyHist hist, uint32_t us);
+
+// 全ヒストグラムを CDC へ出力
+void latency_print(void);
+
+// 全ヒストグラムをクリア（core0 から呼ぶ。core1 のものは latency_core1_poll で消える）
+void latency_reset(void);
+
+// latency_reset の要求があれば core1 のヒストグラムをクリア（core1 の送信処理の先頭で呼ぶ）
+void latency_core1_poll(void);
+
+#endif // LATENCYSTATS_H
@@ -0,0 +1,62 @@
+/**
+ * LineAssembler.cpp - 入力ポートごとの行組み立て実装
+ */
+
+#include "LineAssembler.h"
+
+void line_assembler_init(LineAssembler* as, PortReadFn read) {
+  memset(as, 0, sizeof(*as));
+  as->read = read;
+}
+
+bool line_assembler_next(LineAssembler* as, RxItem* item) {
+  while (true) {
+    if (as->chunk_pos >= as->chunk_len) {
+      as->chunk_len = (uint8_t)as->read(as->chunk, RX_CHUNK_SIZE);
+      as->chunk_pos = 0;
+      if (as->chunk_len == 0) return false;
+      as->chunk_us = micros();
+    }
+
+    uint8_t c = as->chunk[as->chunk_pos++];
+
+    // バイナリフレーム（行の途中では SYNC とみなさない）
+    if (as->frame_len > 0 || (as->line_len == 0 && !as->discarding && c == BIN_FRAME_SYNC)) {
+      as->frame[as->frame_len++] = c;
+      if (as->frame_len == 2 && as->frame[1] != BIN_FRAME_PAYLOAD_LEN) {
+        as->frame_len = 0;
+        as->frame_resyncs++;
+      } else if (as->frame_len == BIN_FRAME_SIZE) {
+        as->frame_len = 0;
+        item->kind = RX_ITEM_FRAME;
+        item->frame = as->frame;
+        item->line = nullptr;
+        item->t_us = as->chunk_us;
+        return true;
+      }
+      continue;
+    }
+
+    if (c == '\n' || c == '\r') {
+      if (as->discarding) {
+        as->discarding = false;
+      } else if (as->line_len > 0) {
+        as->line[as->line_len] = '\0';
+        as->line_len = 0;
+        item->kind = RX_ITEM_LINE;
+        item->line = as->line;
+        item->frame = nullptr;
+        item->t_us = as->chunk_us;
+        return true;
+      }
+    } else if (!as->discarding) {
+      if (as->line_len < RX_LINE_MAX) {
+        as->line[as->line_len++] = (char)c;
+      } else {
+        as->line_len = 0;
+        as->discarding = true;
+        as->long_lines++;
+      }
+    }
+  }
+}
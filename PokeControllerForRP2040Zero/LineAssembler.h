@@ -0,0 +1,58 @@
+/**
+ * LineAssembler.h - 入力ポートごとの行組み立て
+ * v1.6.0: USB CDC と UART で受信バッファを共有せず、
+ *         ポートごとに独立して行・バイナリフレームを組み立てる
+ */
+
+#ifndef LINEASSEMBLER_H
+#define LINEASSEMBLER_H
+
+#include <Arduino.h>
+#include "BinaryProtocol.h"
+
+// 1行の最大長（これを超えると次の改行まで破棄）
+#define RX_LINE_MAX        256
+
+// 一度にポートから読み出すバイト数
+#define RX_CHUNK_SIZE      64
+
+// 受信単位の種類
+typedef enum {
+  RX_ITEM_LINE,   // テキスト1行（NUL終端済み）
+  RX_ITEM_FRAME,  // バイナリフレーム（BIN_FRAME_SIZE バイト）
+} RxItemKind;
+
+typedef struct {
+  RxItemKind     kind;
+  char*          line;   // RX_ITEM_LINE
+  const uint8_t* frame;  // RX_ITEM_FRAME
+  uint32_t       t_us;   // 改行（フレーム末尾）の受信を検出した時刻（UART は検出したポーリング、CDC は読み出したチャンク）
+} RxItem;
+
+// ポートからのまとめ読み関数（読めたバイト数を返す。ブロックしないこと）
+typedef size_t (*PortReadFn)(uint8_t* buf, size_t len);
+
+// 1ポート分の組み立て状態
+typedef struct {
+  PortReadFn read;
+  char     line[RX_LINE_MAX + 1];
+  uint16_t line_len;
+  bool     discarding;     // 行長超過時、改行まで読み飛ばし中
+  uint8_t  frame[BIN_FRAME_SIZE];
+  uint8_t  frame_len;
+  uint8_t  chunk[RX_CHUNK_SIZE];
+  uint8_t  chunk_len;
+  uint8_t  chunk_pos;
+  uint32_t chunk_us;       // chunk を読み出した時刻
+  uint32_t long_lines;     // 破棄した行数
+  uint32_t frame_resyncs;  // LEN 不一致で破棄したフレーム数
+} LineAssembler;
+
+// 初期化
+void line_assembler_init(LineAssembler* as, PortReadFn read);
+
+// 次の受信単位を取得（なければ false）
+// 取得した line/frame は次の line_assembler_next() 呼び出しまで有効
+bool line_assembler_next(LineAssembler* as, RxItem* item);
+
+#endif // LINEASSEMBLER_H
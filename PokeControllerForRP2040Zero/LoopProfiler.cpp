@@ -0,0 +1,159 @@
+/**
+ * LoopProfiler.cpp - loop() の処理段階ごとのサイクル数計測の実装
+ *
+ * 各段階のサンプルは1つのコアだけが書き込む（ENABLE_DUAL_CORE 時、PRESET と SEND は core1）。
+ * 出力側はコピーしてから集計するため、書き込み中の1サンプルが混ざる程度の誤差は許容する。
+ */
+
+#include "LoopProfiler.h"
+#include "ReportTx.h"
+
+#if ENABLE_LOOP_PROFILER
+
+#include <hardware/structs/systick.h>
+#include <pico/platform.h>
+#include <pico/time.h>
+
+#define SYSTICK_MASK      0x00FFFFFFu
+#define SYSTICK_ENABLE    0x1u
+#define SYSTICK_CLKSOURCE 0x4u   // CPU クロックで計数
+#define CYCLES_PER_US     (F_CPU / 1000000)
+// これ以上の区間は SysTick が一周しうるためマイクロ秒から換算（一周の時間の半分で余裕を持たせる。200MHz で約 42ms）
+#define PROF_LONG_US      ((SYSTICK_MASK / CYCLES_PER_US) / 2)
+
+static const char* const phase_names[PROF_PHASE_COUNT] = {
+  "watchdog",
+  "mount",
+  "rx",
+  "parse",
+  "led",
+  "tasks",
+  "preset",
+  "send",
+  "outside",
+};
+
+typedef struct {
+  uint32_t samples[PROF_WINDOW];
+  uint32_t next;       // 次に書き込む位置
+  uint32_t count;      // 記録したサンプル数（累計）
+  uint32_t peak;       // 起動（reset）以降の最大値
+} PhaseWindow;
+
+// コアごとの計測中の状態
+typedef struct {
+  uint32_t mark_cycles;              // 前回の境界の SysTick 値（減算カウンタ）
+  uint32_t mark_us;
+  bool     started;                  // 1周以上計測した
+  uint32_t touched;                  // この周で計測した段階（ビット）
+  uint32_t acc[PROF_PHASE_COUNT];    // この周の段階ごとの合計
+} CoreState;
+
+static PhaseWindow windows[PROF_PHASE_COUNT];
+static CoreState cores[2];
+
+void loop_prof_init_core(void) {
+  systick_hw->csr = 0;
+  systick_hw->rvr = SYSTICK_MASK;
+  systick_hw->cvr = 0;
+  systick_hw->csr = SYSTICK_ENABLE | SYSTICK_CLKSOURCE;
+}
+
+void loop_prof_mark(ProfPhase phase) {
+  CoreState* c = &cores[get_core_num()];
+  uint32_t now_cycles = systick_hw->cvr;
+  uint32_t now_us = time_us_32();
+  uint32_t elapsed_us = now_us - c->mark_us;
+  uint32_t cycles;
+  if (elapsed_us >= PROF_LONG_US) {
+    cycles = elapsed_us * CYCLES_PER_US;   // 24ビットでは数えきれない長い停止
+  } else {
+    cycles = (c->mark_cycles - now_cycles) & SYSTICK_MASK;
+  }
+  c->acc[phase] += cycles;
+  c->touched |= 1u << phase;
+  c->mark_cycles = now_cycles;
+  c->mark_us = now_us;
+}
+
+void loop_prof_begin(void) {
+  uint32_t core = get_core_num();
+  CoreState* c = &cores[core];
+  if (core == 0 && c->started) {
+    loop_prof_mark(PROF_OUTSIDE);
+    return;
+  }
+  c->mark_cycles = systick_hw->cvr;
+  c->mark_us = time_us_32();
+  c->started = true;
+}
+
+void loop_prof_end(void) {
+  CoreState* c = &cores[get_core_num()];
+  uint32_t touched = c->touched;
+  for (int p = 0; p < PROF_PHASE_COUNT; p++) {
+    if (!(touched & (1u << p))) continue;
+    PhaseWindow* w = &windows[p];
+    uint32_t v = c->acc[p];
+    w->samples[w->next] = v;
+    w->next = (w->next + 1) & (PROF_WINDOW - 1);
+    w->count++;
+    if (v > w->peak) w->peak = v;
+    c->acc[p] = 0;
+  }
+  c->touched = 0;
+}
+
+// 挿入ソート（出力時のみ、最大 PROF_WINDOW 件）
+static void sort_samples(uint32_t* v, uint32_t n) {
+  for (uint32_t i = 1; i < n; i++) {
+    uint32_t x = v[i];
+    uint32_t j = i;
+    while (j > 0 && v[j - 1] > x) {
+      v[j] = v[j - 1];
+      j--;
+    }
+    v[j] = x;
+  }
+}
+
+static void print_phase(int p) {
+  static uint32_t sorted[PROF_WINDOW];
+  uint32_t count = windows[p].count;
+  uint32_t peak = windows[p].peak;
+  if (count == 0) {
+    Serial.printf("Prof: %s n=0\n", phase_names[p]);
+    return;
+  }
+  uint32_t n = count < PROF_WINDOW ? count : PROF_WINDOW;
+  memcpy(sorted, windows[p].samples, n * sizeof(uint32_t));
+  sort_samples(sorted, n);
+  uint64_t sum = 0;
+  for (uint32_t i = 0; i < n; i++) sum += sorted[i];
+  Serial.printf("Prof: %s n=%lu min=%lu avg=%lu p50=%lu p90=%lu p99=%lu max=%lu peak=%lu cycles\n",
+                phase_names[p], (unsigned long)n, (unsigned long)sorted[0],
+                (unsigned long)(sum / n),
+                (unsigned long)sorted[(n - 1) * 50 / 100],
+                (unsigned long)sorted[(n - 1) * 90 / 100],
+                (unsigned long)sorted[(n - 1) * 99 / 100],
+                (unsigned long)sorted[n - 1], (unsigned long)peak);
+}
+
+void parse_prof_command(const char* line) {
+  if (strcmp(line, "prof reset") == 0) {
+    memset(windows, 0, sizeof(windows));
+    Serial.println("Prof: reset");
+    return;
+  }
+  Serial.printf("Prof: window=%u clock=%lu MHz preset/send on core%d\n",
+                (unsigned)PROF_WINDOW, (unsigned long)CYCLES_PER_US, ENABLE_DUAL_CORE ? 1 : 0);
+  for (int p = 0; p < PROF_PHASE_COUNT; p++) print_phase(p);
+}
+
+#else
+
+void parse_prof_command(const char* line) {
+  Serial.println("Prof: disabled (ENABLE_LOOP_PROFILER=0)");
+}
+
+#endif // ENABLE_LOOP_PROFILER
@@ -0,0 +1,67 @@
+/**
+ * LoopProfiler.h - loop() の処理段階ごとのサイクル数計測
+ * v1.6.0: 負荷時にまれに起きる数ミリ秒の停止が、どの段階で起きているか特定するため追加
+ *
+ * 各コアの SysTick（24ビット、CPU クロック）で段階の境界ごとに経過サイクルを数える。
+ * 1周（loop() / loop1()）ごとに各段階の合計を1サンプルとし、段階ごとに直近
+ * PROF_WINDOW 個を保持する。統計（最小・平均・最大・パーセンタイル）は prof コマンドの要求時に計算する。
+ * ENABLE_LOOP_PROFILER を 0 にするとマクロは空になり、計測コードは生成されない。
+ */
+
+#ifndef LOOPPROFILER_H
+#define LOOPPROFILER_H
+
+#include <Arduino.h>
+
+#ifndef ENABLE_LOOP_PROFILER
+#define ENABLE_LOOP_PROFILER 1
+#endif
+
+#define PROF_WINDOW         256      // 段階ごとのサンプル数（2のべき乗）
+
+// 計測する段階（loop() 内の処理順）
+typedef enum {
+  PROF_WATCHDOG = 0,  // watchdog_update と周期の記録
+  PROF_MOUNT,         // USB 接続状態の検出
+  PROF_RX,            // 受信単位の取り出し（DMA リング・CDC）と受信エラー監視
+  PROF_PARSE,         // 行・フレームの解析と反映
+  PROF_LED,           // LED 状態の判定と送信
+  PROF_TASKS,         // キーストロークキュー・高レベルAPI・report_publish
+  PROF_PRESET,        // update_preset_state / 再生 / タイムライン / 軌道（ENABLE_DUAL_CORE 時は core1）
+  PROF_SEND,          // 送信キューの取り出しと Gamepad レポート送信（同上）
+  PROF_OUTSIDE,       // 前回の loop() 終了から次の開始まで（USB スタックの処理など、core0 のみ）
+  PROF_PHASE_COUNT
+} ProfPhase;
+
+#if ENABLE_LOOP_PROFILER
+
+// 呼び出したコアの SysTick を開始（setup() / setup1() で1回）
+void loop_prof_init_core(void);
+
+// 1周の開始。区間の基準を現在時刻にする（core0 では前回の終了からの時間を PROF_OUTSIDE に加算）
+void loop_prof_begin(void);
+
+// 前回の境界から現在までを phase に加算し、基準を現在時刻にする
+void loop_prof_mark(ProfPhase phase);
+
+// 1周の終了。このコアで計測した段階の合計をサンプルとして記録
+void loop_prof_end(void);
+
+#define LOOP_PROF_INIT_CORE()   loop_prof_init_core()
+#define LOOP_PROF_BEGIN()       loop_prof_begin()
+#define LOOP_PROF_MARK(phase)   loop_prof_mark(phase)
+#define LOOP_PROF_END()         loop_prof_end()
+
+#else
+
+#define LOOP_PROF_INIT_CORE()   do {} while (0)
+#define LOOP_PROF_BEGIN()       do {} while (0)
+#define LOOP_PROF_MARK(phase)   do {} while (0)
+#define LOOP_PROF_END()         do {} while (0)
+
+#endif // ENABLE_LOOP_PROFILER
+
+// "prof"（段階ごとの統計を CDC へ出力）/ "prof reset"
+void parse_prof_command(const char* line);
+
+#endif // LOOPPROFILER_H
@@ -0,0 +1,246 @@
+/**
+ * Motion.cpp - スティック軌道生成の実装
+ */
+
+#include "Motion.h"
+#include "SpscQueue.h"
+#include "StickMath.h"
+#include <pico/time.h>
+
+typedef struct {
+  uint8_t  kind;
+  uint64_t start_us;
+  uint32_t duration_us;
+  uint8_t  x0, y0;          // RAMP: 開始位置
+  uint8_t  x1, y1;          // RAMP: 目標位置
+  int32_t  from_angle;      // ARC: 開始角度（1/65536 周）
+  int32_t  sweep_angle;     // ARC: 移動量（同、複数周可）
+  int32_t  rate_dps;        // CIRCLE
+  uint8_t  power;
+} MotionProfile;
+
+static SpscQueue<MotionCommand, MOTION_QUEUE_SIZE> commands;
+static MotionProfile profiles[MOTION_STICK_COUNT];   // core1 のみ
+static uint64_t last_eval_us = 0;
+static volatile uint8_t active_kind[MOTION_STICK_COUNT];   // 状態表示用
+
+static int clamp_int(int v, int lo, int hi) {
+  if (v < lo) return lo;
+  if (v > hi) return hi;
+  return v;
+}
+
+// 度 → 1/65536 周
+static int32_t deg_to_angle(int deg) {
+  return (int32_t)deg * 8192 / 45;
+}
+
+static uint8_t* stick_x(switch_report_t* report, int stick) {
+  return stick == MOTION_STICK_LEFT ? &report->lx : &report->rx;
+}
+
+static uint8_t* stick_y(switch_report_t* report, int stick) {
+  return stick == MOTION_STICK_LEFT ? &report->ly : &report->ry;
+}
+
+static void start_profile(const MotionCommand* cmd, switch_report_t* report, uint64_t now) {
+  MotionProfile* p = &profiles[cmd->stick];
+  memset(p, 0, sizeof(*p));
+  p->kind = cmd->kind;
+  p->start_us = now;
+  p->duration_us = cmd->duration_ms * 1000;
+  p->power = cmd->power;
+  switch (cmd->kind) {
+    case MOTION_RAMP:
+      p->x0 = *stick_x(report, cmd->stick);
+      p->y0 = *stick_y(report, cmd->stick);
+      p->x1 = percent_to_value(cmd->x);
+      p->y1 = percent_to_value(-cmd->y);   // +% は上
+      break;
+    case MOTION_ARC:
+      p->from_angle = deg_to_angle(cmd->from_deg);
+      p->sweep_angle = deg_to_angle(cmd->to_deg) - p->from_angle;
+      break;
+    case MOTION_CIRCLE:
+      p->rate_dps = cmd->rate_dps;
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * 1本のスティックを評価（変化した場合 true）
+ */
+static bool eval_profile(int stick, switch_report_t* report, uint64_t now) {
+  MotionProfile* p = &profiles[stick];
+  if (p->kind == MOTION_NONE) return false;
+
+  uint8_t* px = stick_x(report, stick);
+  uint8_t* py = stick_y(report, stick);
+  uint8_t x = STICK_CENTER, y = STICK_CENTER;
+  uint64_t elapsed = now - p->start_us;
+  bool done = elapsed >= p->duration_us;
+
+  switch (p->kind) {
+    case MOTION_HOLD:
+      // PC の行などで上書きされても保持位置に戻す
+      x = p->x1;
+      y = p->y1;
+      break;
+    case MOTION_RAMP:
+      if (done) {
+        x = p->x1;
+        y = p->y1;
+      } else {
+        int32_t t = (int32_t)(elapsed * 65536 / p->duration_us);   // 0～65535
+        x = (uint8_t)(p->x0 + (((int32_t)p->x1 - p->x0) * t) / 65536);
+        y = (uint8_t)(p->y0 + (((int32_t)p->y1 - p->y0) * t) / 65536);
+      }
+      break;
+    case MOTION_ARC: {
+      int64_t sweep = done ? p->sweep_angle
+                           : (int64_t)p->sweep_angle * (int64_t)elapsed / (int64_t)p->duration_us;
+      stick_polar((uint16_t)(p->from_angle + (int32_t)sweep), p->power, &x, &y);
+      break;
+    }
+    case MOTION_CIRCLE: {
+      // 1周分の剰余だけ取れば長時間回しても桁あふれしない
+      uint32_t turn_us = 360000000UL / (uint32_t)abs(p->rate_dps);
+      uint16_t angle = (uint16_t)((elapsed % turn_us) * STICK_ANGLE_TURN / turn_us);
+      if (p->rate_dps < 0) angle = (uint16_t)-angle;
+      stick_polar(angle, p->power, &x, &y);
+      break;
+    }
+    default:   // MOTION_CENTER
+      break;
+  }
+
+  // 直線・円弧は終点で保持、中央復帰は1回書き込んだら解放
+  if (done && (p->kind == MOTION_RAMP || p->kind == MOTION_ARC)) {
+    p->kind = MOTION_HOLD;
+    p->x1 = x;
+    p->y1 = y;
+  } else if (p->kind == MOTION_CENTER) {
+    p->kind = MOTION_NONE;
+  }
+  active_kind[stick] = p->kind;
+
+  if (x == *px && y == *py) return false;
+  *px = x;
+  *py = y;
+  return true;
+}
+
+bool motion_update(switch_report_t* report) {
+  uint64_t now = time_us_64();
+
+  MotionCommand cmd;
+  bool started = false;
+  while (commands.pop(&cmd)) {
+    start_profile(&cmd, report, now);
+    started = true;
+  }
+  if (!started && now - last_eval_us < MOTION_TICK_US) return false;
+  last_eval_us = now;
+
+  bool changed = false;
+  for (int s = 0; s < MOTION_STICK_COUNT; s++) {
+    if (eval_profile(s, report, now)) changed = true;
+  }
+  return changed;
+}
+
+// ==========================================
+// コマンド（core0）
+// ==========================================
+
+static void push_command(const MotionCommand* cmd) {
+  if (!commands.push(*cmd)) {
+    Serial.println("Error: motion queue full");
+    return;
+  }
+  active_kind[cmd->stick] = cmd->kind;
+}
+
+void motion_stop_all(void) {
+  for (int s = 0; s < MOTION_STICK_COUNT; s++) {
+    if (active_kind[s] == MOTION_NONE) continue;
+    MotionCommand cmd = {};
+    cmd.stick = (uint8_t)s;
+    cmd.kind = MOTION_CENTER;
+    push_command(&cmd);
+  }
+}
+
+static const char* kind_name(uint8_t kind) {
+  switch (kind) {
+    case MOTION_HOLD:   return "hold";
+    case MOTION_RAMP:   return "ramp";
+    case MOTION_ARC:    return "arc";
+    case MOTION_CIRCLE: return "circle";
+    case MOTION_CENTER: return "center";
+    default:            return "none";
+  }
+}
+
+/**
+ * "motion <l|r> <軌道> <引数...>"
+ *   motion l ramp   <x%> <y%> <時間ms>         現在位置から直線移動して保持
+ *   motion l arc    <開始度> <終了度> <半径%> <時間ms>   円周上を移動して保持
+ *   motion l circle <度/秒> <半径%>             回転し続ける（負で反時計回り）
+ *   motion l stop                               中央に戻して解放
+ *   motion stop                                 両スティックを中央に戻す
+ *   motion                                      状態表示
+ */
+void parse_motion_command(const char* line) {
+  char side = 0;
+  char op[8] = "";
+  int a1 = 0, a2 = 0, a3 = 0, a4 = 0;
+  int n = sscanf(line, "motion %c %7s", &side, op);
+  MotionCommand cmd = {};
+  cmd.stick = (side == 'r') ? MOTION_STICK_RIGHT : MOTION_STICK_LEFT;
+  bool ok = true;
+
+  if (n < 1) {
+    // 状態表示のみ
+  } else if (strcmp(line, "motion stop") == 0) {
+    motion_stop_all();
+  } else if (n < 2 || (side != 'l' && side != 'r')) {
+    ok = false;
+  } else if (strcmp(op, "stop") == 0) {
+    cmd.kind = MOTION_CENTER;
+    push_command(&cmd);
+  } else if (strcmp(op, "ramp") == 0) {
+    ok = sscanf(line, "motion %*c %*s %d %d %d", &a1, &a2, &a3) == 3 && a3 >= 0;
+    cmd.kind = MOTION_RAMP;
+    cmd.x = (int8_t)clamp_int(a1, -100, 100);
+    cmd.y = (int8_t)clamp_int(a2, -100, 100);
+    cmd.duration_ms = (uint32_t)a3;
+    if (ok) push_command(&cmd);
+  } else if (strcmp(op, "arc") == 0) {
+    ok = sscanf(line, "motion %*c %*s %d %d %d %d", &a1, &a2, &a3, &a4) == 4 && a4 >= 0 &&
+         abs(a1) <= 3600 && abs(a2) <= 3600;
+    cmd.kind = MOTION_ARC;
+    cmd.from_deg = (int16_t)a1;
+    cmd.to_deg = (int16_t)a2;
+    cmd.power = (uint8_t)clamp_int(a3, 0, 100);
+    cmd.duration_ms = (uint32_t)a4;
+    if (ok) push_command(&cmd);
+  } else if (strcmp(op, "circle") == 0) {
+    ok = sscanf(line, "motion %*c %*s %d %d", &a1, &a2) == 2 && a1 != 0 && abs(a1) <= 3600;
+    cmd.kind = MOTION_CIRCLE;
+    cmd.rate_dps = (int16_t)a1;
+    cmd.power = (uint8_t)clamp_int(a2, 0, 100);
+    if (ok) push_command(&cmd);
+  } else {
+    ok = false;
+  }
+
+  if (!ok) {
+    Serial.printf("Error: invalid motion command [%s]\n", line);
+    return;
+  }
+  Serial.printf("Motion: l=%s r=%s\n", kind_name(active_kind[MOTION_STICK_LEFT]),
+                kind_name(active_kind[MOTION_STICK_RIGHT]));
+}
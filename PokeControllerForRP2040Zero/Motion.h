@@ -0,0 +1,54 @@
+/**
+ * Motion.h - スティック軌道の生成（直線・円弧・回転）
+ * v1.6.0: 卵孵化の回転やカメラの旋回を PC から大量の行を送らずに行うため追加
+ *
+ * core1 が送信周期ごとに軌道を評価してスティック値を書き込む。
+ * 角度は 0 = 上、時計回り（tiltLeftStick と同じ: x = sin, y = -cos）。
+ */
+
+#ifndef MOTION_H
+#define MOTION_H
+
+#include <Arduino.h>
+#include "Common.h"
+
+#define MOTION_TICK_US      1000   // 軌道を評価する間隔（変化時送信の最大レートに合わせる）
+#define MOTION_QUEUE_SIZE   8      // core0 → core1 の指示キュー（2のべき乗）
+
+typedef enum {
+  MOTION_STICK_LEFT = 0,
+  MOTION_STICK_RIGHT,
+  MOTION_STICK_COUNT
+} MotionStick;
+
+typedef enum {
+  MOTION_NONE = 0,   // 操作しない（PC・プリセットの値をそのまま使う）
+  MOTION_HOLD,       // 最後の値を保持
+  MOTION_RAMP,       // 現在位置から目標へ直線移動
+  MOTION_ARC,        // 円周上を角度 from → to へ移動
+  MOTION_CIRCLE,     // 一定の角速度で回転し続ける
+  MOTION_CENTER      // 中央に戻して解放
+} MotionKind;
+
+// core0 → core1 の指示
+typedef struct {
+  uint8_t  stick;          // MotionStick
+  uint8_t  kind;           // MotionKind
+  int8_t   x, y;           // RAMP: 目標（-100～100%）
+  int16_t  from_deg;       // ARC: 開始角度
+  int16_t  to_deg;         // ARC: 終了角度（差が 360 を超えると複数周）
+  int16_t  rate_dps;       // CIRCLE: 角速度（度/秒、負で反時計回り）
+  uint8_t  power;          // ARC/CIRCLE: 半径（0～100%）
+  uint32_t duration_ms;    // RAMP/ARC: 所要時間
+} MotionCommand;
+
+// core1: 実行中の軌道を評価して report のスティックを更新。変更した場合 true
+bool motion_update(switch_report_t* report);
+
+// core0: 両スティックの軌道を止めて中央に戻す（'end' コマンドなど）
+void motion_stop_all(void);
+
+// "motion ..." コマンドを処理
+void parse_motion_command(const char* line);
+
+#endif // MOTION_H
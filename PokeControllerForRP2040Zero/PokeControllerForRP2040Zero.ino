@@ -8,9 +8,39 @@
 #include "Presets.h"
 #include "HighLevelAPI.h"
 #include "JapaneseKeyboard.h"
+#include "Benchmark.h"
+#include "BinaryProtocol.h"
+#include "LineAssembler.h"
+#include "UartRx.h"
+#include "ReportTx.h"
+#include "PresetStore.h"
+#include "CommandTable.h"
+#include "LatencyStats.h"
+#include "Trace.h"
+#include "Replay.h"
+#include "Timeline.h"
+#include "Motion.h"
+#include "FlowControl.h"
+#include "UartBaud.h"
+#include "LoopProfiler.h"
 
 /**
  * RP2040-Zero Switch Controller
+ * v1.6.0: On-device Benchmark (bench), Host Simulation Build (host_bench), Binary Frame Protocol, UART DMA Ring RX,
+ *         Per-port Line Assemblers & RX Arbitration, Dual-core Report Transmission,
+ *         Send-on-change Reporting (up to 1kHz), Non-blocking Keystroke Queue,
+ *         Step-based HighLevelAPI (api command), Preset Bytecode Interpreter,
+ *         Flash-stored Presets (preset command), Compile-time Command Keyword Table,
+ *         Drift-free Microsecond Preset Scheduling (pstat), Latency Histograms (stats),
+ *         HID Report Trace (trace), On-device Record/Replay (rec, replay),
+ *         Timestamped Report Timeline (tl), Stick Motion Profiles (motion),
+ *         Fixed-point Stick Math Tables, Credit-based Flow Control (flow, @seq ACK),
+ *         UART Baud Negotiation up to 3 Mbaud (baud),
+ *         Change-only NeoPixel Updates (led),
+ *         Loop Phase Profiler (prof),
+ *         6KRO Keyboard State (Press/Release chords, per-key Release),
+ *         On-device Kana to Romaji Typing,
+ *         Adaptive Fast Typing (kbmode, kbcal)
  * v1.5.0: Date/Year Change Commands Changed to Preset Format
  * v1.4.3: Architecture Refactoring (State Machine, No SetCommand), Protocol Optimization
  * v1.4.2: Code Cleanup (Common.h)
@@ -35,6 +65,15 @@ enum LedState { LED_DISCONNECT, LED_IDLE, LED_ACTIVE, LED_ERROR };
 static LedState current_led_state = LED_DISCONNECT;
 static uint32_t error_blink_start = 0; // エラー表示開始時刻
 
+// v1.6.0: 色が変わった時だけ送信する（毎ループの show() をやめる）
+// 波形は PIO が生成し、1ピクセル分は TX FIFO に収まるため CPU は待たない。
+// show() は前回から 300us 未満だとラッチ待ちで止まるので、その場合は次の loop() へ延期する。
+static constexpr uint32_t LED_COLOR_UNSET = 0xFFFFFFFFu;
+static uint32_t led_shown_color = LED_COLOR_UNSET;  // 最後に送信した色
+static bool     led_every_loop = false;             // true: 毎ループ送信（v1.5.0 までの動作、比較計測用）
+static uint32_t led_shows = 0;                      // 送信回数
+static uint32_t led_deferred = 0;                   // ラッチ待ちで延期した回数
+
 // ==========================================
 // 1) 定数・タイミング設定 (安定性と保守性のための集約)
 // ==========================================
@@ -42,20 +81,45 @@ static constexpr uint32_t WATCHDOG_TIMEOUT_MS = 10000;   // 10秒に延長
 static constexpr uint32_t COMMAND_TIMEOUT_MS = 250;     // 通信途絶判定
 static constexpr bool ENABLE_SAFETY_TIMEOUT = false;    // v1.3.1 - v1.3.2 準拠（必要に応じてtrue）
 static constexpr uint32_t ERROR_RECOVERY_MS = 500;      // エラー表示時間
-static constexpr uint32_t GAMEPAD_REPORT_INTERVAL_MS = 8;
 static constexpr uint32_t USB_INIT_TIMEOUT_MS = 2000;
-static constexpr uint32_t KEY_TYPE_DELAY_MS = 20;
 static constexpr uint32_t LED_ACTIVE_MS = 50;           // コマンド受信時の点灯時間 (30->50msに微増)
 
 static constexpr int UART_TX_PIN = 0;
 static constexpr int UART_RX_PIN = 1;
-static constexpr uint32_t UART_BAUD = 115200; 
+static constexpr uint32_t UART_BAUD = UART_BAUD_DEFAULT;  // v1.6.0: 起動時のレート（baud コマンドで変更）
+
+// v1.6.0: 受信はポートごとに独立して組み立てる
+// USB CDC は LineAssembler、UART は UartRx の DMA リング
+enum RxPort { RX_PORT_CDC, RX_PORT_UART, RX_PORT_COUNT };
 
-#define RX_BUFFER_SIZE 256
-static char rx_buffer[RX_BUFFER_SIZE];
-static int  rx_index = 0;
+// ポート間の調停方式
+enum RxArbitration {
+  RX_ARB_PRIORITY,     // CDC を優先して処理し、その後 UART
+  RX_ARB_ROUND_ROBIN,  // 1単位ずつ交互に処理
+  RX_ARB_EXCLUSIVE,    // 最初に受信したポートに占有させる（他ポートは破棄）
+};
+static constexpr RxArbitration DEFAULT_RX_ARBITRATION = RX_ARB_PRIORITY;
+static constexpr uint32_t RX_EXCLUSIVE_IDLE_MS = 1000;  // 占有ポートがこの時間無通信なら解除
+static constexpr int RX_ITEMS_PER_LOOP = 32;            // 1ループで処理する最大単位数
+#ifdef CFG_TUD_CDC_RX_BUFSIZE
+static constexpr uint32_t CDC_RX_CAPACITY = CFG_TUD_CDC_RX_BUFSIZE;   // フロー制御で通知する CDC の受信容量
+#else
+static constexpr uint32_t CDC_RX_CAPACITY = 256;
+#endif
+
+static LineAssembler cdc_assembler;
+static RxArbitration rx_arbitration = DEFAULT_RX_ARBITRATION;
+static int      rx_owner = -1;                          // 占有中のポート（-1: なし）
+static uint32_t rx_owner_last_ms = 0;
+static uint8_t  rx_rr_next = RX_PORT_CDC;
+static uint32_t rx_dropped[RX_PORT_COUNT] = {0, 0};     // 占有モードで破棄した単位数
+static int      rx_line_port = RX_PORT_CDC;             // 処理中の行を受信したポート
+static uint32_t bin_frame_errors = 0;
 static uint32_t last_command_ms = 0;
 
+// 受信エラー検出用（前回値との差分でエラーLEDを点灯）
+static uint32_t last_rx_errors = 0;
+
 // ==========================================
 // 2) HID レポート設定 (Gamepad & Keyboard)
 // ==========================================
@@ -82,6 +146,12 @@ switch_report_t gp_report = {0, HAT_CENTER, STICK_CENTER, STICK_CENTER, STICK_CE
 
 // 前方宣言
 static void parse_protocol_line(char* line);
+static size_t cdc_read(uint8_t* buf, size_t len);
+static bool rx_port_next(int port, RxItem* item);
+static void dispatch_rx_item(int port, RxItem* item);
+static void handle_rx_line(int port, char* line, uint32_t newline_us);
+static void handle_rx_frame(const uint8_t* frame, uint32_t newline_us);
+static void signal_rx_error();
 static void update_led();
 static bool is_hex_char(char c);
 static uint8_t ascii_to_hid(char c);
@@ -91,6 +161,9 @@ static uint8_t ascii_to_hid(char c);
 // リカバリ判定用
 static bool was_mounted = false;
 
+// v1.6.0: loop() 周期の計測用
+static uint32_t last_loop_us = 0;
+
 // Gamepadレポートの初期化
 static void reset_gamepad_report() {
   gp_report.buttons = 0;
@@ -108,9 +181,11 @@ static void reset_gamepad_report() {
 
 void setup() {
   watchdog_enable(WATCHDOG_TIMEOUT_MS, 1);
+  LOOP_PROF_INIT_CORE();
 
   // USB CDC (デバッグ用シリアル) 開始
   Serial.begin(115200);
+  line_assembler_init(&cdc_assembler, cdc_read);
 
   // USB Device 設定
   TinyUSBDevice.detach(); 
@@ -146,14 +221,45 @@ void setup() {
   update_led();
 
   // UART (Poke-Controller 通信用) 初期化
-  Serial1.setTX(UART_TX_PIN);
-  Serial1.setRX(UART_RX_PIN);
-  Serial1.begin(UART_BAUD);
+  // v1.6.0: Serial1 ではなく DMA リングバッファで受信
+  uart_rx_begin(UART_TX_PIN, UART_RX_PIN, UART_BAUD);
+  uart_baud_begin(UART_BAUD);
+
+  // v1.6.0: Flash に保存したプリセットを読み込み
+  preset_store_begin();
+  replay_begin();
+
+  // v1.6.0: 送信レポートの記録（core1 が送信を始める前に初期化）
+  trace_begin();
+
+  // v1.6.0: レポート送信開始（ENABLE_DUAL_CORE 時は core1 が送信）
+  report_tx_begin();
 }
 
+#if ENABLE_DUAL_CORE
+// core1: レポート送信とプリセットのタイミング処理のみを行う
+void setup1() {
+  LOOP_PROF_INIT_CORE();
+}
+
+void loop1() {
+  LOOP_PROF_BEGIN();
+  report_tx_task();
+  LOOP_PROF_MARK(PROF_SEND);
+  LOOP_PROF_END();
+}
+#endif
+
 void loop() {
+  LOOP_PROF_BEGIN();
   watchdog_update();
 
+  // v1.6.0: loop() 1周の時間
+  uint32_t loop_now_us = micros();
+  if (last_loop_us != 0) latency_record(LAT_LOOP, loop_now_us - last_loop_us);
+  last_loop_us = loop_now_us;
+  LOOP_PROF_MARK(PROF_WATCHDOG);
+
   bool is_mounted = TinyUSBDevice.mounted();
   if (was_mounted && !is_mounted) {
     gp_report.buttons = 0;
@@ -163,47 +269,53 @@ void loop() {
     current_led_state = LED_IDLE;
   }
   was_mounted = is_mounted;
+  LOOP_PROF_MARK(PROF_MOUNT);
 
-  // 1. UART & USB 受信処理
-  // ポートをまたいでパケットが分割されることはない前提で、
-  // どちらかデータがある方を優先してバッファに取り込む簡易実装
-  Stream* active_serial = nullptr;
-  
-  if (Serial.available()) {
-    active_serial = &Serial;
-  } else if (Serial1.available()) {
-    active_serial = &Serial1;
-  }
-
-  if (active_serial) {
-    while (active_serial->available() > 0) {
-      char c = (char)active_serial->read();
-      
-      if (c == '\n' || c == '\r') {
-        if (rx_index > 0) {
-          rx_buffer[rx_index] = '\0';
-          parse_protocol_line(rx_buffer);
-          rx_index = 0; 
-          last_command_ms = millis();
-          current_led_state = LED_ACTIVE;
-        }
+  // 1. UART & USB 受信処理（ポートごとに独立した組み立て＋調停）
+  if (rx_owner >= 0 && millis() - rx_owner_last_ms > RX_EXCLUSIVE_IDLE_MS) {
+    rx_owner = -1;
+  }
+  RxItem item;
+  int handled = 0;
+  if (rx_arbitration == RX_ARB_ROUND_ROBIN) {
+    int idle_ports = 0;
+    while (handled < RX_ITEMS_PER_LOOP && idle_ports < RX_PORT_COUNT) {
+      int port = rx_rr_next;
+      rx_rr_next = (uint8_t)((rx_rr_next + 1) % RX_PORT_COUNT);
+      bool got = rx_port_next(port, &item);
+      LOOP_PROF_MARK(PROF_RX);
+      if (got) {
+        dispatch_rx_item(port, &item);
+        LOOP_PROF_MARK(PROF_PARSE);
+        handled++;
+        idle_ports = 0;
       } else {
-        if (rx_index < RX_BUFFER_SIZE - 1) {
-          rx_buffer[rx_index++] = c;
-        } else {
-          Serial.println("Error: RX Buffer Overflow!");
-          rx_index = 0;
-          current_led_state = LED_ERROR;
-          error_blink_start = millis();
-          // 改行まで読み飛ばして同期を戻す
-          while (active_serial->available() > 0) {
-            if (active_serial->read() == '\n') break;
-          }
-        }
+        idle_ports++;
+      }
+    }
+  } else {
+    for (int port = 0; port < RX_PORT_COUNT; port++) {
+      while (handled < RX_ITEMS_PER_LOOP && rx_port_next(port, &item)) {
+        LOOP_PROF_MARK(PROF_RX);
+        dispatch_rx_item(port, &item);
+        LOOP_PROF_MARK(PROF_PARSE);
+        handled++;
       }
     }
   }
 
+  // v1.6.0: ボーレート切り替えの確認期限・受信エラー監視
+  uart_baud_task();
+
+  UartRxStats uart_stats;
+  uart_rx_get_stats(&uart_stats);
+  uint32_t rx_errors = uart_stats.overruns + uart_stats.long_lines + cdc_assembler.long_lines;
+  if (rx_errors != last_rx_errors) {
+    last_rx_errors = rx_errors;
+    signal_rx_error();
+  }
+  LOOP_PROF_MARK(PROF_RX);
+
   if (current_led_state == LED_ERROR) {
     if (millis() - error_blink_start > ERROR_RECOVERY_MS) {
       current_led_state = is_mounted ? LED_IDLE : LED_DISCONNECT;
@@ -215,27 +327,125 @@ void loop() {
   }
   else if (ENABLE_SAFETY_TIMEOUT && (millis() - last_command_ms > COMMAND_TIMEOUT_MS)) {
     reset_gamepad_report();
-    usb_keyboard.keyboardRelease(0);
+    send_keyboard_release(TRACE_SRC_SYSTEM);
     current_led_state = LED_IDLE;
   }
 
   update_led();
+  LOOP_PROF_MARK(PROF_LED);
+
+  // v1.6.0: キーストロークキュー・高レベルAPIのステップ実行
+  update_keyboard_queue();
+  update_highlevel_actions();
+
+  // 受信以外で変更された gp_report（切断時のリセットなど）を送信側へ渡す
+  report_publish();
+  LOOP_PROF_MARK(PROF_TASKS);
+
+#if !ENABLE_DUAL_CORE
+  // v1.4.0: プリセット状態更新・Gamepad Report 送信（シングルコア構成）
+  report_tx_task();
+  LOOP_PROF_MARK(PROF_SEND);
+#endif
+  LOOP_PROF_END();
+}
 
-  // v1.4.0: プリセット状態更新
-  update_preset_state();
+// USB CDC のまとめ読み
+static size_t cdc_read(uint8_t* buf, size_t len) {
+  int avail = Serial.available();
+  if (avail <= 0) return 0;
+  if ((size_t)avail < len) len = (size_t)avail;
+  return Serial.read(buf, len);
+}
+
+// ポートから次の受信単位を取得
+static bool rx_port_next(int port, RxItem* item) {
+  if (port == RX_PORT_CDC) return line_assembler_next(&cdc_assembler, item);
+  return uart_rx_next(item);
+}
+
+// v1.6.0: ポートの受信バッファの空き（フロー制御の ACK で通知）
+static uint32_t rx_port_free(int port) {
+  if (port == RX_PORT_UART) return uart_rx_free();
+  int avail = Serial.available();
+  uint32_t used = avail > 0 ? (uint32_t)avail : 0;
+  return used < CDC_RX_CAPACITY ? CDC_RX_CAPACITY - used : 0;
+}
 
-  // Gamepad Report 送信
-  static uint32_t last_report_ms = 0;
-  uint32_t now = millis();
-  if (now - last_report_ms >= GAMEPAD_REPORT_INTERVAL_MS) {
-    last_report_ms = now;
-    if (is_mounted && usb_gamepad.ready()) {
-      usb_gamepad.sendReport(0, &gp_report, sizeof(gp_report));
+// 調停方式に従って受信単位を処理
+static void dispatch_rx_item(int port, RxItem* item) {
+  if (rx_arbitration == RX_ARB_EXCLUSIVE) {
+    // 調停方式の変更だけはどのポートからでも受け付ける
+    // （command_lookup と同じく行頭の単語全体で一致させる。"arbx" などは対象外）
+    bool has_seq;
+    uint32_t seq;
+    const char* cmd = (item->kind == RX_ITEM_LINE) ? flow_strip_seq(item->line, &has_seq, &seq) : "";
+    bool is_arb_cmd = (command_word_length(cmd) == 3 && strncmp(cmd, "arb", 3) == 0);
+    if (rx_owner < 0) {
+      rx_owner = port;
+    } else if (rx_owner != port && !is_arb_cmd) {
+      rx_dropped[port]++;
+      return;
     }
+    if (rx_owner == port) rx_owner_last_ms = millis();
   }
+
+  if (item->kind == RX_ITEM_FRAME) {
+    handle_rx_frame(item->frame, item->t_us);
+  } else {
+    handle_rx_line(port, item->line, item->t_us);
+  }
+}
+
+// 受信した1行を処理
+static void handle_rx_line(int port, char* line, uint32_t newline_us) {
+  // v1.6.0: "@<番号> " 付きの行は処理後に ACK を返す（flow on の時のみ）
+  bool has_seq;
+  uint32_t seq;
+  line = flow_strip_seq(line, &has_seq, &seq);
+  rx_line_port = port;
+  parse_protocol_line(line);
+  uint32_t parsed_us = micros();
+  latency_record(LAT_NEWLINE_TO_PARSED, parsed_us - newline_us);
+  replay_capture(&gp_report, newline_us);
+  report_mark_input(newline_us, parsed_us);
+  report_mark_source(TRACE_SRC_HEX);
+  report_publish();
+  if (has_seq) {
+    Print& out = (port == RX_PORT_UART) ? (Print&)uart_tx : (Print&)Serial;
+    flow_ack(out, port, seq, rx_port_free(port));
+  }
+  last_command_ms = millis();
+  current_led_state = LED_ACTIVE;
+}
+
+// 受信したバイナリフレームを処理
+static void handle_rx_frame(const uint8_t* frame, uint32_t newline_us) {
+  GamepadInput in;
+  if (!decode_binary_frame(frame, &in)) {
+    bin_frame_errors++;
+    return;
+  }
+  apply_gamepad_input(in.raw_btns, in.hat, in.lx, in.ly, in.rx, in.ry);
+  report_mark_fields(report_input_fields(in.raw_btns));
+  uint32_t parsed_us = micros();
+  latency_record(LAT_NEWLINE_TO_PARSED, parsed_us - newline_us);
+  replay_capture(&gp_report, newline_us);
+  report_mark_input(newline_us, parsed_us);
+  report_mark_source(TRACE_SRC_BINARY);
+  report_publish();
+  last_command_ms = millis();
+  current_led_state = LED_ACTIVE;
+}
+
+// 受信エラーをLEDで通知
+static void signal_rx_error() {
+  current_led_state = LED_ERROR;
+  error_blink_start = millis();
 }
 
 // LED更新関数 (非ブロッキング)
+// v1.6.0: 色の決定は毎ループ、送信は変化時のみ（点滅も 100ms ごとの変化時だけ送信）
 static void update_led() {
   uint32_t color = 0;
   switch (current_led_state) {
@@ -247,8 +457,17 @@ static void update_led() {
       else color = 0;
       break;
   }
+  if (!led_every_loop) {
+    if (color == led_shown_color) return;
+    if (!neopixel.canShow()) {
+      led_deferred++;
+      return;
+    }
+  }
   neopixel.setPixelColor(0, color);
   neopixel.show();
+  led_shown_color = color;
+  led_shows++;
 }
 
 static bool is_hex_char(char c) {
@@ -267,63 +486,391 @@ static uint8_t ascii_to_hid(char c) {
   return 0;
 }
 
-// プロトコル解析関数
-static void parse_protocol_line(char* line) {
-  if (strlen(line) < 1) return;
+// ==========================================
+// v1.6.0: コマンド処理関数（キーワード表から呼ばれる）
+// ==========================================
 
-  // ==================== v1.4.0: プリセットコマンド ====================
-  if (!is_hex_char(line[0])) {
-    // プリセットコマンド
-    parse_preset_command(line);
+// 組み込みプリセット（arg は ProcessState）
+static void cmd_start_preset(char* line, int arg) {
+  start_builtin_preset((ProcessState)arg);
+}
+
+// 実機ベンチマーク（CDCへ結果出力）
+static void cmd_bench(char* line, int arg) {
+  run_benchmark(parse_protocol_line, is_command_keyword);
+  Serial.printf("Bench: binary frame errors=%lu\n", (unsigned long)bin_frame_errors);
+}
 
-    // 既存の特殊コマンドに該当しない場合はreturnしない
-    // 既存の"end"などの処理に続く
+// レポート送信間隔のジッター（"jitter reset" で集計をリセット）
+static void cmd_jitter(char* line, int arg) {
+  ReportTxStats st;
+  report_tx_get_stats(&st);
+  uint32_t intervals = st.sent > 1 ? st.sent - 1 : 0;
+  if (intervals > 0) {
+    uint64_t mean = st.interval_sum_us / intervals;
+    uint64_t sq_mean = st.interval_sq_sum / intervals;
+    uint64_t var = sq_mean > mean * mean ? sq_mean - mean * mean : 0;
+    Serial.printf("Jitter: %s n=%lu mean=%lu us min=%lu us max=%lu us var=%lu us^2 qfull=%lu\n",
+                  ENABLE_DUAL_CORE ? "dual" : "single", (unsigned long)intervals,
+                  (unsigned long)mean, (unsigned long)st.interval_min_us,
+                  (unsigned long)st.interval_max_us, (unsigned long)var,
+                  (unsigned long)st.queue_full);
+  } else {
+    Serial.println("Jitter: n=0");
+  }
+  if (strcmp(line, "jitter reset") == 0) {
+    report_tx_reset_stats();
   }
+}
 
-  // 1. 文字列タイピング（v1.4.0: JIS対応版に更新）
-  if (line[0] == '"') {
-    Serial.printf("Keyboard: Typing JP string [%s]\n", &line[1]);
-    type_jp_string(&line[1]);
+// レポート送信モード（"report fixed" / "report change <Hz>"）と送信統計
+static void cmd_report(char* line, int arg) {
+  if (strcmp(line, "report fixed") == 0) {
+    report_tx_set_mode(REPORT_MODE_FIXED, 0);
+  } else if (strncmp(line, "report change", 13) == 0) {
+    uint32_t hz = (line[13] == ' ') ? (uint32_t)strtoul(&line[14], nullptr, 10) : 1000;
+    report_tx_set_mode(REPORT_MODE_ON_CHANGE, hz);
+  }
+  uint32_t hz = 0;
+  ReportMode mode = report_tx_get_mode(&hz);
+  ReportTxStats st;
+  report_tx_get_stats(&st);
+  Serial.printf("Report: mode=%s max=%lu Hz sent=%lu on_change=%lu not_ready=%lu\n",
+                mode == REPORT_MODE_FIXED ? "fixed" : "change", (unsigned long)hz,
+                (unsigned long)st.sent, (unsigned long)st.sent_on_change,
+                (unsigned long)st.skipped_not_ready);
+  if (st.change_count > 0) {
+    Serial.printf("Report: change->send n=%lu avg=%lu us max=%lu us\n",
+                  (unsigned long)st.change_count,
+                  (unsigned long)(st.change_sum_us / st.change_count),
+                  (unsigned long)st.change_max_us);
+  }
+}
+
+// 受信バッファ統計（"rxstat reset" で最大値をリセット）
+static void cmd_rxstat(char* line, int arg) {
+  UartRxStats st;
+  uart_rx_get_stats(&st);
+  Serial.printf("RX: uart bytes=%lu avail=%lu hwm=%lu/%u overruns=%lu long=%lu wrapped=%lu line_errors=%lu\n",
+                (unsigned long)st.bytes, (unsigned long)st.available,
+                (unsigned long)st.high_water, (unsigned)UART_RX_RING_SIZE,
+                (unsigned long)st.overruns, (unsigned long)st.long_lines,
+                (unsigned long)st.wrapped, (unsigned long)st.line_errors);
+  Serial.printf("RX: cdc long=%lu resync=%lu frame_errors=%lu\n",
+                (unsigned long)cdc_assembler.long_lines,
+                (unsigned long)cdc_assembler.frame_resyncs,
+                (unsigned long)bin_frame_errors);
+  Serial.printf("RX: arb=%d owner=%d dropped cdc=%lu uart=%lu\n",
+                (int)rx_arbitration, rx_owner,
+                (unsigned long)rx_dropped[RX_PORT_CDC], (unsigned long)rx_dropped[RX_PORT_UART]);
+  if (strcmp(line, "rxstat reset") == 0) {
+    uart_rx_reset_high_water();
+  }
+}
+
+// ポート調停方式の切り替え
+static void cmd_arb(char* line, int arg) {
+  const char* mode = (line[3] == ' ') ? &line[4] : "";
+  if (strcmp(mode, "priority") == 0)      rx_arbitration = RX_ARB_PRIORITY;
+  else if (strcmp(mode, "rr") == 0)       rx_arbitration = RX_ARB_ROUND_ROBIN;
+  else if (strcmp(mode, "lock") == 0)     rx_arbitration = RX_ARB_EXCLUSIVE;
+  else {
+    Serial.printf("Error: unknown arb mode [%s]\n", mode);
     return;
   }
+  rx_owner = -1;
+  Serial.printf("Command: arb %s\n", mode);
+}
 
-  // 2. 個別キー操作: Key/Press/Release (Raw HID Keycode)
-  if (strncmp(line, "Key ", 4) == 0) {
-    char* endptr;
-    uint8_t k = (uint8_t)strtoul(&line[4], &endptr, 16);
-    if (endptr != &line[4]) {
-      uint8_t keys[6] = { k, 0, 0, 0, 0, 0 };
-      usb_keyboard.keyboardReport(0, 0, keys);
-      delay(KEY_TYPE_DELAY_MS);
-      usb_keyboard.keyboardRelease(0);
-    }
+// 高レベルAPI（"api push A 100 3" など）
+static void cmd_api(char* line, int arg) {
+  parse_api_command(line);
+}
+
+// 遅延ヒストグラム（"stats reset" でクリア）
+static void cmd_stats(char* line, int arg) {
+  latency_print();
+  if (strcmp(line, "stats reset") == 0) {
+    latency_reset();
+  }
+}
+
+// PC 入力の記録（"rec start" / "rec stop"）と再生（"replay [回数]" / "replay stop"）
+static void cmd_rec(char* line, int arg) {
+  parse_rec_command(line);
+}
+
+static void cmd_replay(char* line, int arg) {
+  parse_replay_command(line);
+}
+
+// タイムライン（"tl <経過us> <HEX>,..." / "tl go" / "tl stop"）
+static void cmd_tl(char* line, int arg) {
+  parse_timeline_command(line);
+}
+
+// スティック軌道（"motion l circle 720 100" など）
+static void cmd_motion(char* line, int arg) {
+  parse_motion_command(line);
+}
+
+// フロー制御（"flow on|off"）
+static void cmd_flow(char* line, int arg) {
+  parse_flow_command(line);
+}
+
+// LED の送信方式（"led change" / "led always"）と送信回数
+// loop() 周期への影響は "stats reset" → "stats" の loop 行で比較する
+static void cmd_led(char* line, int arg) {
+  const char* mode = (line[3] == ' ') ? &line[4] : "";
+  if (strcmp(mode, "change") == 0)      led_every_loop = false;
+  else if (strcmp(mode, "always") == 0) led_every_loop = true;
+  else if (mode[0] != '\0') {
+    Serial.println("Error: led change|always");
     return;
   }
-  if (strncmp(line, "Press ", 6) == 0) {
+  Serial.printf("LED: mode=%s shows=%lu deferred=%lu\n",
+                led_every_loop ? "always" : "change",
+                (unsigned long)led_shows, (unsigned long)led_deferred);
+}
+
+// loop() の段階ごとのサイクル数（"prof reset" でクリア）
+static void cmd_prof(char* line, int arg) {
+  parse_prof_command(line);
+}
+
+// UART のボーレート切り替え（"baud <レート>" / "baud ok <パターン>" / "baud reset"）
+static void cmd_baud(char* line, int arg) {
+  parse_baud_command(line, rx_line_port == RX_PORT_UART);
+}
+
+// 送信レポートの記録（"trace on|off|clear|dump"、引数なしで状態表示）
+static void cmd_trace(char* line, int arg) {
+  const char* sub = line[5] == ' ' ? &line[6] : "";
+  if (strcmp(sub, "dump") == 0) {
+    trace_dump();
+    return;
+  }
+  if (strcmp(sub, "on") == 0) trace_set_enabled(true);
+  else if (strcmp(sub, "off") == 0) trace_set_enabled(false);
+  else if (strcmp(sub, "clear") == 0) trace_clear();
+  else if (sub[0] != '\0') {
+    Serial.println("Error: trace on|off|clear|dump");
+    return;
+  }
+  TraceStatus st;
+  trace_get_status(&st);
+  Serial.printf("Trace: %s n=%lu/%u total=%lu missed=%lu\n",
+                st.enabled ? "on" : "off", (unsigned long)st.count, (unsigned)TRACE_CAPACITY,
+                (unsigned long)st.total, (unsigned long)st.missed);
+}
+
+// プリセットの計画時間と実測の比較
+static void cmd_pstat(char* line, int arg) {
+  PresetTimingStats st;
+  get_preset_timing(&st);
+  if (st.steps == 0) {
+    Serial.printf("Preset: state=%u steps=0\n", (unsigned)st.state);
+    return;
+  }
+  Serial.printf("Preset: state=%u steps=%lu planned=%lu ms actual=%lu ms drift=%ld us\n",
+                (unsigned)st.state, (unsigned long)st.steps,
+                (unsigned long)(st.planned_us / 1000), (unsigned long)(st.actual_us / 1000),
+                (long)(int64_t)(st.actual_us - st.planned_us));
+  Serial.printf("Preset: late avg=%lu us max=%lu us resyncs=%lu\n",
+                (unsigned long)(st.late_sum_us / st.steps), (unsigned long)st.late_max_us,
+                (unsigned long)st.resyncs);
+}
+
+// 保存プリセットの書き込み・一覧・削除（"preset begin <名前>" など）
+static void cmd_preset(char* line, int arg) {
+  parse_preset_store_command(line);
+}
+
+// キーボード入力状態（queued / typing / done）
+static void cmd_kbstat(char* line, int arg) {
+  KeyQueueStatus st;
+  get_key_queue_status(&st);
+  Serial.printf("Keyboard: %s queued=%u typed=%lu dropped=%lu\n",
+                st.typing ? "typing" : "done", (unsigned)st.queued,
+                (unsigned long)st.typed, (unsigned long)st.dropped);
+  uint8_t modifier;
+  uint8_t keys[KEY_ROLLOVER];
+  keyboard_get_held(&modifier, keys);
+  Serial.printf("Keyboard: held mod=%02X keys=%02X %02X %02X %02X %02X %02X\n", modifier,
+                keys[0], keys[1], keys[2], keys[3], keys[4], keys[5]);
+  // v1.6.0: 直前の入力の速度（キューが空になるまで）
+  uint32_t cps10 = st.last_us > 0 ? (uint32_t)((uint64_t)st.last_keys * 10000000ULL / st.last_us) : 0;
+  Serial.printf("Keyboard: last keys=%lu time=%lu ms cps=%lu.%lu\n",
+                (unsigned long)st.last_keys, (unsigned long)(st.last_us / 1000),
+                (unsigned long)(cps10 / 10), (unsigned long)(cps10 % 10));
+}
+
+// v1.6.0: 空白区切りの HID キーコード（16進）を読む
+// 戻り値: 個数（読めない値や max 超過は -1）
+static int parse_key_codes(const char* p, uint8_t* codes, int max) {
+  int n = 0;
+  while (true) {
+    while (*p == ' ') p++;
+    if (*p == '\0') return n;
     char* endptr;
-    uint8_t k = (uint8_t)strtoul(&line[6], &endptr, 16);
-    if (endptr != &line[6]) {
-      uint8_t keys[6] = { k, 0, 0, 0, 0, 0 };
-      usb_keyboard.keyboardReport(0, 0, keys);
+    unsigned long v = strtoul(p, &endptr, 16);
+    if (endptr == p || v > 0xFF || (*endptr != ' ' && *endptr != '\0') || n >= max) return -1;
+    codes[n++] = (uint8_t)v;
+    p = endptr;
+  }
+}
+
+// 入力モード（"kbmode safe" / "kbmode fast [押下ms 待ちms]"）
+static void cmd_kbmode(char* line, int arg) {
+  parse_kbmode_command(line);
+}
+
+// 入力タイミングの校正（"kbcal start" / "kbcal <段階>"）
+static void cmd_kbcal(char* line, int arg) {
+  parse_kbcal_command(line);
+}
+
+// 個別キー操作: Key/Press/Release (Raw HID Keycode)
+// v1.6.0: 複数のキーコードを1つのレポートで送る（E0-E7 は修飾キー）
+static void cmd_key(char* line, int arg) {
+  // 修飾キー＋1キーを1回押して離す（"Key E0 06" = Ctrl+C）
+  uint8_t codes[KEY_ROLLOVER + 8];
+  int n = parse_key_codes(&line[3], codes, (int)sizeof(codes));
+  uint8_t key = 0;
+  uint8_t modifier = 0;
+  for (int i = 0; i < n; i++) {
+    if (codes[i] >= KEY_MODIFIER_FIRST && codes[i] <= KEY_MODIFIER_LAST) {
+      modifier |= (uint8_t)(1u << (codes[i] - KEY_MODIFIER_FIRST));
+    } else if (key == 0) {
+      key = codes[i];
+    } else {
+      n = -1;
+      break;
     }
+  }
+  if (n <= 0) {
+    Serial.println("Error: Key <hex> [modifier hex ...]");
     return;
   }
-  if (strncmp(line, "Release ", 8) == 0) {
-    // 特定キーのReleaseは管理が複雑なため、現在はRelease Allのみとする
-    // もし特定キーだけ離したい場合は現在のReport状態を管理する必要がある
-    usb_keyboard.keyboardRelease(0); 
+  enqueue_key(key, modifier);
+}
+
+static void cmd_press(char* line, int arg) {
+  uint8_t codes[KEY_ROLLOVER + 8];
+  int n = parse_key_codes(&line[5], codes, (int)sizeof(codes));
+  if (n <= 0) {
+    Serial.println("Error: Press <hex> [hex ...]");
     return;
   }
+  if (!keyboard_press_keys(codes, n, TRACE_SRC_HEX)) {
+    Serial.printf("Error: keyboard rollover (max %d keys)\n", KEY_ROLLOVER);
+  }
+}
 
-  // 3. 'end' コマンド: 全てをニュートラルに戻す
-  if (strncmp(line, "end", 3) == 0) {
-    reset_gamepad_report();
-    usb_keyboard.keyboardRelease(0);
-    Serial.println("Command: end (Reset all)");
+static void cmd_release(char* line, int arg) {
+  // v1.6.0: キーコードを指定した場合はそのキーだけ離す（引数なしは全て）
+  uint8_t codes[KEY_ROLLOVER + 8];
+  int n = parse_key_codes(&line[7], codes, (int)sizeof(codes));
+  if (n < 0) {
+    Serial.println("Error: Release [hex ...]");
     return;
   }
+  if (n == 0) {
+    send_keyboard_release(TRACE_SRC_HEX);
+  } else {
+    keyboard_release_keys(codes, n, TRACE_SRC_HEX);
+  }
+}
+
+// 'end' コマンド: 全てをニュートラルに戻す
+static void cmd_end(char* line, int arg) {
+  stop_highlevel_actions();
+  replay_stop();
+  timeline_stop();
+  motion_stop_all();
+  reset_gamepad_report();
+  clear_key_queue();
+  send_keyboard_release(TRACE_SRC_HEX);
+  Serial.println("Command: end (Reset all)");
+}
+
+// v1.6.0: 行頭キーワード → 処理関数（コンパイル時に完全ハッシュ表を生成）
+static constexpr CommandEntry command_entries[] = {
+  // プリセットコマンド
+  {"mash_a",        cmd_start_preset, MASH_A},
+  {"aaabb",         cmd_start_preset, AAABB},
+  {"auto_league",   cmd_start_preset, AUTO_LEAGUE},
+  {"inf_watt",      cmd_start_preset, INF_WATT},
+  {"pickupberry",   cmd_start_preset, PICKUPBERRY},
+  {"changethedate", cmd_start_preset, CHANGETHEDATE},
+  {"changetheyear", cmd_start_preset, CHANGETHEYEAR},
+  // キーボード
+  {"Key",           cmd_key,          0},
+  {"Press",         cmd_press,        0},
+  {"Release",       cmd_release,      0},
+  {"end",           cmd_end,          0},
+  // 設定・統計
+  {"bench",         cmd_bench,        0},
+  {"jitter",        cmd_jitter,       0},
+  {"report",        cmd_report,       0},
+  {"rxstat",        cmd_rxstat,       0},
+  {"arb",           cmd_arb,          0},
+  {"api",           cmd_api,          0},
+  {"preset",        cmd_preset,       0},
+  {"pstat",         cmd_pstat,        0},
+  {"stats",         cmd_stats,        0},
+  {"kbstat",        cmd_kbstat,       0},
+  {"kbmode",        cmd_kbmode,       0},
+  {"kbcal",         cmd_kbcal,        0},
+  {"trace",         cmd_trace,        0},
+  {"rec",           cmd_rec,          0},
+  {"replay",        cmd_replay,       0},
+  {"tl",            cmd_tl,           0},
+  {"motion",        cmd_motion,       0},
+  {"flow",          cmd_flow,         0},
+  {"baud",          cmd_baud,         0},
+  {"led",           cmd_led,          0},
+  {"prof",          cmd_prof,         0},
+};
+static constexpr auto command_table = make_command_table<128>(command_entries);
+static_assert(command_table.perfect, "command keywords collide (duplicate keyword?)");
+
+bool is_command_keyword(const char* line) {
+  return command_lookup(command_table, line) != nullptr;
+}
 
-  // 4. 標準 Gamepad プロトコル (HEX)
+// プロトコル解析関数
+static void parse_protocol_line(char* line) {
+  if (line[0] == '\0') return;
+
+  // 1. 文字列タイピング（v1.4.0: JIS対応版に更新）
+  if (line[0] == '"') {
+    // v1.6.0: キューに積んで即座に戻る（入力は loop() で1キーずつ進む）
+    int queued = type_jp_string(&line[1]);
+    Serial.printf("Keyboard: Typing JP string [%s] queued=%d\n", &line[1], queued);
+    return;
+  }
+
+  // 2. コマンド・プリセット
+  // v1.6.0: "aaabb" "changethedate" など先頭がHEX文字の名前も含め、
+  // HEX判定より先にキーワード表を1回引く
+  const CommandEntry* cmd = command_lookup(command_table, line);
+  if (cmd != nullptr) {
+    cmd->handler(line, cmd->arg);
+    return;
+  }
+
+  // v1.6.0: 保存プリセット（名前だけの行。HEX 行は必ず空白を含む）
+  if (strchr(line, ' ') == nullptr) {
+    const PresetOp* program = preset_store_find(line);
+    if (program != nullptr) {
+      start_user_preset(program);
+      return;
+    }
+  }
+
+  // 3. 標準 Gamepad プロトコル (HEX)
   if (!is_hex_char(line[0])) return;
 
   char* p = line;
@@ -339,17 +886,6 @@ static void parse_protocol_line(char* line) {
   while (*p == ' ') p++;
   uint8_t ry = (uint8_t)strtoul(p, &p, 16);
 
-  bool use_right = raw_btns & 0x01;
-  bool use_left  = raw_btns & 0x02;
-  gp_report.buttons = raw_btns >> 2;
-  gp_report.hat = hat;
-
-  if (use_left && use_right) {
-    gp_report.lx = lx; gp_report.ly = ly;
-    gp_report.rx = rx; gp_report.ry = ry;
-  } else if (use_right) {
-    gp_report.rx = lx; gp_report.ry = ly;
-  } else if (use_left) {
-    gp_report.lx = lx; gp_report.ly = ly;
-  }
+  apply_gamepad_input(raw_btns, hat, lx, ly, rx, ry);
+  report_mark_fields(report_input_fields(raw_btns));
 }
@@ -0,0 +1,406 @@
+/**
+ * PresetStore.cpp - Flash 保存プリセット（LittleFS）
+ * v1.6.0: プリセットを /presets/<名前> に6バイト命令の列として保存
+ *
+ * 起動時に全プリセットを RAM に読み込み、名前は FNV-1a ハッシュの
+ * オープンアドレス表で引く（保存数によらず数回の比較で済む）。
+ * 実行は core1 のバイトコードインタプリタが RAM 上の命令列を直接読む。
+ */
+
+#include "PresetStore.h"
+#include "CommandTable.h"
+#include <LittleFS.h>
+
+#define PRESET_OP_BYTES  6   // ファイル上の1命令（op, arg, duration LE, waittime LE）
+
+typedef struct {
+  bool     used;
+  char     name[PRESET_NAME_MAX + 1];
+  uint8_t  op_count;
+  uint32_t crc;
+  PresetOp ops[PRESET_USER_MAX_OPS];
+} StoredPreset;
+
+static StoredPreset slots[PRESET_STORE_SLOTS];
+static int8_t name_index[PRESET_INDEX_SIZE];   // スロット番号（-1 は空き）
+static bool store_ready = false;
+
+// アップロード中のプリセット
+static char staging_name[PRESET_NAME_MAX + 1];
+static uint8_t staging_buf[PRESET_USER_MAX_OPS * PRESET_OP_BYTES];
+static size_t staging_len = 0;
+static bool staging_active = false;
+
+// ==========================================
+// ハッシュ・CRC
+// ==========================================
+
+static uint32_t name_hash(const char* name) {
+  uint32_t h = 2166136261u;
+  while (*name) {
+    h ^= (uint8_t)*name++;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t len) {
+  crc = ~crc;
+  while (len--) {
+    crc ^= *data++;
+    for (int b = 0; b < 8; b++) {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+  }
+  return ~crc;
+}
+
+// ==========================================
+// 名前索引
+// ==========================================
+
+static int index_lookup(const char* name) {
+  uint32_t pos = name_hash(name) & (PRESET_INDEX_SIZE - 1);
+  for (int probe = 0; probe < PRESET_INDEX_SIZE; probe++) {
+    int slot = name_index[pos];
+    if (slot < 0) return -1;
+    if (strcmp(slots[slot].name, name) == 0) return slot;
+    pos = (pos + 1) & (PRESET_INDEX_SIZE - 1);
+  }
+  return -1;
+}
+
+static void index_insert(int slot) {
+  uint32_t pos = name_hash(slots[slot].name) & (PRESET_INDEX_SIZE - 1);
+  while (name_index[pos] >= 0) {
+    pos = (pos + 1) & (PRESET_INDEX_SIZE - 1);
+  }
+  name_index[pos] = (int8_t)slot;
+}
+
+// 削除時は作り直す（線形探査の連鎖を切らないため）
+static void index_rebuild(void) {
+  memset(name_index, -1, sizeof(name_index));
+  for (int i = 0; i < PRESET_STORE_SLOTS; i++) {
+    if (slots[i].used) index_insert(i);
+  }
+}
+
+// ==========================================
+// 検証・変換
+// ==========================================
+
+static bool valid_name(const char* name) {
+  size_t len = strlen(name);
+  if (len == 0 || len > PRESET_NAME_MAX) return false;
+  for (size_t i = 0; i < len; i++) {
+    char c = name[i];
+    if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_')) return false;
+  }
+  // コマンド名・組み込みプリセット名はキーワード表が先に一致するため使えない
+  return !is_command_keyword(name);
+}
+
+static void decode_ops(const uint8_t* buf, size_t count, PresetOp* ops) {
+  for (size_t i = 0; i < count; i++, buf += PRESET_OP_BYTES) {
+    ops[i].op       = buf[0];
+    ops[i].arg      = buf[1];
+    ops[i].duration = (uint16_t)(buf[2] | (buf[3] << 8));
+    ops[i].waittime = (uint16_t)(buf[4] | (buf[5] << 8));
+  }
+}
+
+/**
+ * 命令列の検証（インタプリタが範囲外を読まないことを保証する）
+ * 戻り値: エラー内容（正常なら nullptr）
+ */
+static const char* validate_ops(const PresetOp* ops, size_t count) {
+  if (count == 0) return "empty";
+  int depth = 0;
+  for (size_t i = 0; i < count; i++) {
+    const PresetOp* op = &ops[i];
+    switch (op->op) {
+      case OP_HALT:
+      case OP_RET:
+      case OP_LSTICK:
+        break;
+      case OP_PRESS:
+        if (op->arg > COMMAND_HAT_TOP_LEFT) return "bad button";
+        break;
+      case OP_LOOP:
+        if (op->arg == 0) return "loop count 0";
+        if (++depth > PRESET_LOOP_DEPTH) return "loop too deep";
+        break;
+      case OP_ENDLOOP:
+        if (--depth < 0) return "unbalanced loop";
+        break;
+      case OP_CALL:
+        if (op->arg >= SUB_COUNT) return "bad subroutine";
+        break;
+      case OP_JUMP:
+        if (op->arg >= count) return "bad jump";
+        break;
+      default:
+        return "bad opcode";
+    }
+  }
+  if (depth != 0) return "unbalanced loop";
+  uint8_t last = ops[count - 1].op;
+  if (last != OP_HALT && last != OP_JUMP) return "must end with halt or jump";
+  return nullptr;
+}
+
+static void make_path(char* path, size_t size, const char* name) {
+  snprintf(path, size, PRESET_STORE_DIR "/%s", name);
+}
+
+// ==========================================
+// 読み込み・保存
+// ==========================================
+
+static int find_free_slot(void) {
+  for (int i = 0; i < PRESET_STORE_SLOTS; i++) {
+    if (!slots[i].used) return i;
+  }
+  return -1;
+}
+
+/**
+ * バイト列をスロットに格納（検証済みであること）
+ */
+static void fill_slot(int slot, const char* name, const uint8_t* buf, size_t len) {
+  StoredPreset* p = &slots[slot];
+  strncpy(p->name, name, PRESET_NAME_MAX);
+  p->name[PRESET_NAME_MAX] = '\0';
+  p->op_count = (uint8_t)(len / PRESET_OP_BYTES);
+  p->crc = crc32_update(0, buf, len);
+  decode_ops(buf, p->op_count, p->ops);
+  p->used = true;
+}
+
+void preset_store_begin(void) {
+  memset(name_index, -1, sizeof(name_index));
+  if (!LittleFS.begin()) {
+    Serial.println("Preset: flash filesystem not available");
+    return;
+  }
+  if (!LittleFS.exists(PRESET_STORE_DIR)) {
+    LittleFS.mkdir(PRESET_STORE_DIR);
+  }
+  store_ready = true;
+
+  Dir dir = LittleFS.openDir(PRESET_STORE_DIR);
+  while (dir.next()) {
+    String file_name = dir.fileName();
+    const char* name = file_name.c_str();
+    File f = dir.openFile("r");
+    if (!f) continue;
+    bool too_large = f.size() > sizeof(staging_buf);
+    size_t len = too_large ? 0 : (size_t)f.read(staging_buf, sizeof(staging_buf));
+    f.close();
+
+    PresetOp ops[PRESET_USER_MAX_OPS];
+    size_t count = len / PRESET_OP_BYTES;
+    decode_ops(staging_buf, count, ops);
+    int slot = find_free_slot();
+    if (slot < 0 || too_large || !valid_name(name) || len % PRESET_OP_BYTES != 0 ||
+        validate_ops(ops, count) != nullptr) {
+      Serial.printf("Preset: skipped %s\n", name);
+      continue;
+    }
+    fill_slot(slot, name, staging_buf, len);
+    index_insert(slot);
+  }
+}
+
+const PresetOp* preset_store_find(const char* name) {
+  int slot = index_lookup(name);
+  return (slot < 0) ? nullptr : slots[slot].ops;
+}
+
+/**
+ * アップロード内容を検証して Flash とスロットに書き込む
+ */
+static void commit_staging(void) {
+  staging_active = false;
+  if (staging_len == 0 || staging_len % PRESET_OP_BYTES != 0) {
+    Serial.printf("Error: preset size %u is not a multiple of %d\n",
+                  (unsigned)staging_len, PRESET_OP_BYTES);
+    return;
+  }
+
+  PresetOp ops[PRESET_USER_MAX_OPS];
+  size_t count = staging_len / PRESET_OP_BYTES;
+  decode_ops(staging_buf, count, ops);
+  const char* err = validate_ops(ops, count);
+  if (err != nullptr) {
+    Serial.printf("Error: preset %s: %s\n", staging_name, err);
+    return;
+  }
+
+  int slot = index_lookup(staging_name);
+  if (slot >= 0 && preset_program_in_use(slots[slot].ops)) {
+    Serial.printf("Error: preset %s is running\n", staging_name);
+    return;
+  }
+  bool replace = (slot >= 0);
+  if (!replace) slot = find_free_slot();
+  if (slot < 0) {
+    Serial.println("Error: preset store full");
+    return;
+  }
+
+  char path[32];
+  make_path(path, sizeof(path), staging_name);
+  File f = LittleFS.open(path, "w");
+  if (!f || f.write(staging_buf, staging_len) != staging_len) {
+    if (f) f.close();
+    Serial.printf("Error: preset %s write failed\n", staging_name);
+    return;
+  }
+  f.close();
+
+  fill_slot(slot, staging_name, staging_buf, staging_len);
+  if (!replace) index_insert(slot);
+  Serial.printf("Preset: saved %s ops=%u crc=%08lx\n", staging_name,
+                (unsigned)slots[slot].op_count, (unsigned long)slots[slot].crc);
+}
+
+static int hex_nibble(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+/**
+ * 16進文字列をアップロードバッファに追加（空白・タブは無視）
+ */
+static bool append_hex(const char* hex) {
+  while (*hex) {
+    if (*hex == ' ' || *hex == '\t') { hex++; continue; }
+    int hi = hex_nibble(hex[0]);
+    int lo = (hi < 0) ? -1 : hex_nibble(hex[1]);
+    if (lo < 0) return false;
+    if (staging_len >= sizeof(staging_buf)) return false;
+    staging_buf[staging_len++] = (uint8_t)((hi << 4) | lo);
+    hex += 2;
+  }
+  return true;
+}
+
+// ==========================================
+// コマンド処理
+// ==========================================
+
+// 先頭から count 語（"preset" とサブコマンド）を読み飛ばし、引数の先頭を返す
+// （sscanf と同じく語の間の空白・タブの数によらない）
+static const char* skip_words(const char* p, int count) {
+  for (int i = 0; i < count; i++) {
+    while (*p == ' ' || *p == '\t') p++;
+    while (*p != '\0' && *p != ' ' && *p != '\t') p++;
+  }
+  while (*p == ' ' || *p == '\t') p++;
+  return p;
+}
+
+/**
+ * preset コマンド
+ *   preset begin <名前>   アップロード開始
+ *   preset data <16進>    命令バイト列を追加（複数行可）
+ *   preset end            検証して Flash に保存
+ *   preset list           保存済み一覧
+ *   preset del <名前>     削除
+ *   preset sum <名前>     Flash 上の内容の CRC-32
+ *   preset stop           実行中のプリセットを停止
+ */
+bool parse_preset_store_command(const char* line) {
+  if (strncmp(line, "preset", 6) != 0 || (line[6] != '\0' && line[6] != ' ')) return false;
+
+  char op[8] = "";
+  char name[PRESET_NAME_MAX + 2] = "";
+  int n = sscanf(line, "preset %7s %16s", op, name);
+
+  if (n >= 1 && strcmp(op, "stop") == 0) {
+    stop_preset();
+    Serial.println("Preset: stop");
+    return true;
+  }
+
+  if (!store_ready) {
+    Serial.println("Error: flash filesystem not available");
+    return true;
+  }
+
+  if (n < 1 || strcmp(op, "list") == 0) {
+    int used = 0;
+    for (int i = 0; i < PRESET_STORE_SLOTS; i++) {
+      if (!slots[i].used) continue;
+      used++;
+      if (n >= 1) {
+        Serial.printf("Preset: %s ops=%u crc=%08lx\n", slots[i].name,
+                      (unsigned)slots[i].op_count, (unsigned long)slots[i].crc);
+      }
+    }
+    Serial.printf("Preset: stored=%d free=%d\n", used, PRESET_STORE_SLOTS - used);
+  } else if (strcmp(op, "begin") == 0) {
+    if (n < 2 || !valid_name(name)) {
+      Serial.printf("Error: invalid preset name [%s]\n", name);
+      return true;
+    }
+    strcpy(staging_name, name);
+    staging_len = 0;
+    staging_active = true;
+    Serial.printf("Preset: begin %s\n", staging_name);
+  } else if (strcmp(op, "data") == 0) {
+    if (!staging_active) {
+      Serial.println("Error: preset data without begin");
+    } else if (!append_hex(skip_words(line, 2))) {
+      staging_active = false;
+      Serial.println("Error: invalid preset data (aborted)");
+    }
+  } else if (strcmp(op, "end") == 0) {
+    if (!staging_active) {
+      Serial.println("Error: preset end without begin");
+    } else {
+      commit_staging();
+    }
+  } else if (strcmp(op, "del") == 0) {
+    int slot = index_lookup(name);
+    if (slot < 0) {
+      Serial.printf("Error: preset %s not found\n", name);
+    } else if (preset_program_in_use(slots[slot].ops)) {
+      Serial.printf("Error: preset %s is running\n", name);
+    } else {
+      char path[32];
+      make_path(path, sizeof(path), name);
+      LittleFS.remove(path);
+      slots[slot].used = false;
+      index_rebuild();
+      Serial.printf("Preset: deleted %s\n", name);
+    }
+  } else if (strcmp(op, "sum") == 0) {
+    int slot = index_lookup(name);
+    char path[32];
+    make_path(path, sizeof(path), name);
+    File f = (slot < 0) ? File() : LittleFS.open(path, "r");
+    if (!f) {
+      Serial.printf("Error: preset %s not found\n", name);
+      return true;
+    }
+    uint8_t buf[64];
+    uint32_t crc = 0;
+    size_t total = 0;
+    int len;
+    while ((len = f.read(buf, sizeof(buf))) > 0) {
+      crc = crc32_update(crc, buf, (size_t)len);
+      total += (size_t)len;
+    }
+    f.close();
+    Serial.printf("Preset: %s bytes=%u crc=%08lx %s\n", name, (unsigned)total,
+                  (unsigned long)crc, (crc == slots[slot].crc) ? "ok" : "mismatch");
+  } else {
+    Serial.printf("Error: invalid preset command [%s]\n", line);
+  }
+  return true;
+}
@@ -0,0 +1,27 @@
+/**
+ * PresetStore.h - Flash 保存プリセット（LittleFS）
+ * v1.6.0: シリアル経由でプリセットを書き込み、再書き込みなしで追加・変更できるようにする
+ */
+
+#ifndef PRESETSTORE_H
+#define PRESETSTORE_H
+
+#include <Arduino.h>
+#include "Presets.h"
+
+#define PRESET_STORE_DIR      "/presets"
+#define PRESET_STORE_SLOTS    16   // 保存できるプリセット数
+#define PRESET_NAME_MAX       15   // 名前の最大長（英小文字・数字・_）
+#define PRESET_USER_MAX_OPS   64   // 1プリセットの最大命令数
+#define PRESET_INDEX_SIZE     32   // 名前ハッシュ表のサイズ（2のべき乗、SLOTS の2倍）
+
+// 起動時に Flash から全プリセットを読み込み、名前の索引を作る
+void preset_store_begin(void);
+
+// 名前で検索（見つからなければ nullptr）。保存数によらずほぼ一定時間
+const PresetOp* preset_store_find(const char* name);
+
+// "preset ..." コマンドを処理（該当しなければ false）
+bool parse_preset_store_command(const char* line);
+
+#endif // PRESETSTORE_H
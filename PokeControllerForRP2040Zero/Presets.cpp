@@ -2,457 +2,450 @@
  * Presets.cpp - プリセットコマンド実装（Pico互換方式）
  * v1.4.0: プリセットコマンド機能追加
  * v1.5.0: Pico互換コマンドシステム実装、日付変更コマンドを固定プリセット方式に変更
+ * v1.6.0: 3種類の GetNextReportFromCommands* をバイトコードインタプリタ1つに統合
+ *         各フェーズをシーケンス開始からの絶対期限（マイクロ秒）で判定し、誤差を累積させない
  */
 
 #include "Presets.h"
 #include "Common.h"
+#include "Benchmark.h"
+#include "PresetStore.h"
+#include <pico/time.h>
 
 // ==========================================
 // 外部変数（コマンド実行状態管理）
 // ==========================================
 ProcessState proc_state = PRESET_NONE;
 
-// コマンド実行フラグ
-static bool blduration = false;
-static bool blwaittime = false;
-
-// コマンドカウンタ
-static int cnt_command = 0;
-
 // 前回のレポート（コマンド実行前の状態）
 static switch_report_t last_pc_report;
 
-// タイムスタンプ
-static unsigned long s_ultime = 0;
+// v1.6.0: プリセットが操作するレポート（core1 の送信用レポート）
+static switch_report_t* s_report = nullptr;
 
-// ステップサイズバッファ
-static int step_size_buf = INT8_MAX;
+// v1.6.0: core0 から要求されたプリセット（core1 の update_preset_state で開始）
+static volatile int s_requested_state = -1;
+static const PresetOp* volatile s_requested_program = nullptr;
 
-// 年変更カウンタ（日付変更用）
-static int YearChangeCnt = 0;
-static int MonthChangeCnt = 0;
-static int DayChangeCnt = 0;
+// v1.6.0: 絶対期限スケジューラ
+// 現フェーズの期限 = s_origin_us + s_planned_us（計画時間の累計）
+// 実際の遷移時刻ではなく計画値から次の期限を決めるため、遅れが次へ持ち越されない
+static uint64_t s_origin_us = 0;    // シーケンス開始時刻
+static uint64_t s_planned_us = 0;   // 開始から現フェーズ終了までの計画時間
+static PresetTimingStats s_timing;
+
+// ==========================================
+// インタプリタ状態
+// ==========================================
+typedef enum {
+  PHASE_FETCH = 0,   // 次の命令を取り出す
+  PHASE_PRESS,       // 押下中（duration 待ち）
+  PHASE_WAIT         // 解放後（waittime 待ち）
+} PresetPhase;
+
+typedef struct {
+  const PresetOp* program;
+  uint8_t pc;
+} PresetFrame;
+
+typedef struct {
+  uint8_t start_pc;    // ループ本体の先頭
+  uint8_t remaining;   // 残り回数
+} PresetLoop;
+
+static const PresetOp* volatile s_root_program = nullptr;  // 開始したプログラム
+static const PresetOp* s_program = nullptr;   // 実行中のプログラム（サブルーチン含む）
+static const PresetOp* s_current = nullptr;   // 実行中の PRESS 命令
+static uint8_t s_pc = 0;
+static PresetPhase s_phase = PHASE_FETCH;
+
+static PresetFrame call_stack[PRESET_CALL_DEPTH];
+static uint8_t call_depth = 0;
+static PresetLoop loop_stack[PRESET_LOOP_DEPTH];
+static uint8_t loop_depth = 0;
 
 // ==========================================
 // ヘルパー関数
 // ==========================================
 
 /**
- * レポート送信（gp_reportに反映）
+ * 次のフェーズを予約（期限を計画時間だけ進める）
+ */
+static inline void schedulePhase(uint16_t planned_ms) {
+  s_planned_us += (uint64_t)planned_ms * 1000ULL;
+}
+
+/**
+ * 期限到達判定（到達時は期限からの遅れを記録）
  */
-static inline void sendReportOnly(switch_report_t report) {
-  // gp_reportを更新（.inoでSwitchに送信される）
-  gp_report = report;
+static bool phaseDue(void) {
+  uint64_t now = time_us_64();
+  uint64_t deadline = s_origin_us + s_planned_us;
+  if (now < deadline) return false;
+
+  uint32_t late = (uint32_t)(now - deadline);
+  s_timing.steps++;
+  s_timing.late_sum_us += late;
+  if (late > s_timing.late_max_us) s_timing.late_max_us = late;
+  s_timing.planned_us = s_planned_us;
+  s_timing.actual_us = now - s_origin_us;
+  bench_record_preset_step((uint8_t)proc_state, late);
+  return true;
+}
+
+/**
+ * 押下開始時に大きく遅れていたら（Flash 書き込み中の停止など）、
+ * 押下時間を削って追いつくのではなく期限の基準を現在に合わせ直す
+ */
+static void resyncIfLate(void) {
+  uint64_t now = time_us_64();
+  uint64_t deadline = s_origin_us + s_planned_us;
+  if (now > deadline + PRESET_RESYNC_US) {
+    s_origin_us += now - deadline;
+    s_timing.resyncs++;
+  }
 }
 
 // ==========================================
-// コマンド配列データ
+// プリセットプログラム
 // ==========================================
+static const PresetOp sub_open_settings[] = {
+  P_PRESS(COMMAND_LEFT, 40, 160),
+  P_PRESS(COMMAND_DOWN, 40, 0),
+  P_PRESS(COMMAND_LEFT, 40, 0),
+  P_PRESS(COMMAND_A, 40, 860),
+  P_LOOP(7),
+    P_PRESS(COMMAND_DOWN, 40, 0),
+    P_PRESS(COMMAND_RS_DOWN, 40, 0),
+  P_ENDLOOP(),
+  P_RET()
+};
 
-const SetCommand mash_a_commands[] =
-{
-  {COMMAND_A, 20, 20}
+static const PresetOp sub_open_datetime[] = {
+  P_PRESS(COMMAND_DOWN, 40, 40),
+  P_PRESS(COMMAND_A, 40, 260),
+  P_PRESS(COMMAND_DOWN, 40, 0),
+  P_PRESS(COMMAND_RS_DOWN, 40, 0),
+  P_PRESS(COMMAND_DOWN, 600, 0),
+  P_PRESS(COMMAND_RS_DOWN, 40, 0),
+  P_PRESS(COMMAND_DOWN, 40, 0),
+  P_PRESS(COMMAND_A, 40, 210),
+  P_PRESS(COMMAND_DOWN, 40, 0),
+  P_PRESS(COMMAND_RS_DOWN, 40, 40),
+  P_PRESS(COMMAND_A, 40, 210),
+  P_RET()
 };
 
-const SetCommand aaabb_commands[] =
-{
-  {COMMAND_A, 40, 260},
-  {COMMAND_A, 40, 260},
-  {COMMAND_A, 40, 260},
-  {COMMAND_B, 40, 310},
-  {COMMAND_B, 40, 310}
+static const PresetOp sub_skip_day[] = {
+  P_CALL(SUB_OPEN_SETTINGS),
+  P_PRESS(COMMAND_DOWN, 40, 0),
+  P_PRESS(COMMAND_RS_DOWN, 40, 0),
+  P_CALL(SUB_OPEN_DATETIME),
+  P_PRESS(COMMAND_RIGHT, 40, 0),
+  P_PRESS(COMMAND_RS_RIGHT, 40, 0),
+  P_PRESS(COMMAND_UP, 40, 0),
+  P_PRESS(COMMAND_RIGHT, 40, 0),
+  P_PRESS(COMMAND_RS_RIGHT, 40, 0),
+  P_PRESS(COMMAND_RIGHT, 40, 40),
+  P_PRESS(COMMAND_A, 40, 310),
+  P_PRESS(COMMAND_HOME, 100, 700),
+  P_PRESS(COMMAND_HOME, 100, 700),
+  P_RET()
 };
 
-const SetCommand auto_league_commands[] =
-{
-  {COMMAND_A, 20, 980},
-  {COMMAND_A, 20, 980},
-  {COMMAND_A, 20, 980},
-  {COMMAND_A, 20, 980},
-  {COMMAND_A, 20, 980},
-  {COMMAND_A, 20, 980},
-  {COMMAND_A, 20, 980},
-  {COMMAND_A, 20, 980},
-  {COMMAND_A, 20, 980},
-  {COMMAND_A, 20, 980},
-  {COMMAND_B, 20, 980}
+static const PresetOp* const preset_subroutines[SUB_COUNT] = {
+  sub_open_settings,
+  sub_open_datetime,
+  sub_skip_day,
 };
 
-const SetCommand inf_watt_commands[] =
-{
-  {COMMAND_A, 40, 960},
-  {COMMAND_B, 40, 1460},
-  {COMMAND_B, 40, 1460},
-  {COMMAND_B, 40, 1460},
-  {COMMAND_B, 40, 1460},
-  {COMMAND_B, 40, 1460},
-  {COMMAND_A, 40, 1460},
-  {COMMAND_A, 40, 3460},
-  {COMMAND_HOME, 100, 700},
-  {COMMAND_LEFT, 40, 160},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_LEFT, 40, 0},
-  {COMMAND_A, 40, 860},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 40},
-  {COMMAND_A, 40, 260},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 600, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_A, 40, 210},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 40},
-  {COMMAND_A, 40, 210},
-  {COMMAND_RIGHT, 40, 0},
-  {COMMAND_RS_RIGHT, 40, 0},
-  {COMMAND_UP, 40, 0},
-  {COMMAND_RIGHT, 40, 0},
-  {COMMAND_RS_RIGHT, 40, 0},
-  {COMMAND_RIGHT, 40, 40},
-  {COMMAND_A, 40, 310},
-  {COMMAND_HOME, 100, 700},
-  {COMMAND_HOME, 100, 700},
-  {COMMAND_B, 40, 740},
-  {COMMAND_A, 40, 3440}
+static const PresetOp mash_a_program[] = {
+  P_PRESS(COMMAND_A, 20, 20),
+  P_JUMP(0)
 };
 
-const SetCommand pickupberry_commands[] =
-{
-  {COMMAND_L, 40, 40},
-  {COMMAND_A, 40, 360},
-  {COMMAND_A, 40, 360},
-  {COMMAND_A, 40, 360},
-  {COMMAND_B, 40, 460},
-  {COMMAND_B, 40, 460},
-  {COMMAND_B, 40, 460},
-  {COMMAND_B, 40, 460},
-  {COMMAND_B, 40, 460},
-  {COMMAND_B, 40, 460},
-  {COMMAND_B, 40, 460},
-  {COMMAND_B, 40, 460},
-  {COMMAND_B, 40, 460},
-  {COMMAND_B, 40, 460},
-  {COMMAND_B, 40, 460},
-  {COMMAND_B, 40, 460},
-  {COMMAND_B, 40, 460},
-  {COMMAND_B, 40, 460},
-  {COMMAND_B, 40, 460},
-  {COMMAND_B, 40, 460},
-  {COMMAND_B, 40, 460},
-  {COMMAND_B, 40, 460},
-  {COMMAND_HOME, 100, 700},
-  {COMMAND_LEFT, 40, 160},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_LEFT, 40, 0},
-  {COMMAND_A, 40, 860},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 40},
-  {COMMAND_A, 40, 260},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 600, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_A, 40, 210},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 40},
-  {COMMAND_A, 40, 210},
-  {COMMAND_RIGHT, 40, 0},
-  {COMMAND_RS_RIGHT, 40, 0},
-  {COMMAND_UP, 40, 0},
-  {COMMAND_RIGHT, 40, 0},
-  {COMMAND_RS_RIGHT, 40, 0},
-  {COMMAND_RIGHT, 40, 40},
-  {COMMAND_A, 40, 310},
-  {COMMAND_HOME, 100, 700},
-  {COMMAND_HOME, 100, 700}
+static const PresetOp aaabb_program[] = {
+  P_LOOP(3),
+    P_PRESS(COMMAND_A, 40, 260),
+  P_ENDLOOP(),
+  P_LOOP(2),
+    P_PRESS(COMMAND_B, 40, 310),
+  P_ENDLOOP(),
+  P_JUMP(0)
 };
 
-const SetCommand changethedate_commands[] =
-{
-  {COMMAND_NONE, 40, 40},
-  {COMMAND_LEFT, 40, 160},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_LEFT, 40, 0},
-  {COMMAND_A, 40, 860},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 40},
-  {COMMAND_A, 40, 260},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 600, 0},
-  {COMMAND_RS_DOWN, 40, 0},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_A, 40, 210},
-  {COMMAND_DOWN, 40, 0},
-  {COMMAND_RS_DOWN, 40, 40},
-  {COMMAND_A, 40, 210},
-  {COMMAND_UP, 40, 40},
-  {COMMAND_RIGHT, 40, 0},
-  {COMMAND_UP, 40, 40},
-  {COMMAND_RS_RIGHT, 40, 0},
-  {COMMAND_UP, 40, 40},
-  {COMMAND_RIGHT, 40, 0},
-  {COMMAND_RS_RIGHT, 40, 0},
-  {COMMAND_RIGHT, 40, 40},
-  {COMMAND_A, 40, 310},
-  {COMMAND_HOME, 100, 700},
-  {COMMAND_NONE, 100, 700}
+static const PresetOp auto_league_program[] = {
+  P_LSTICK(172, 7),
+  P_LOOP(10),
+    P_PRESS(COMMAND_A, 20, 980),
+  P_ENDLOOP(),
+  P_PRESS(COMMAND_B, 20, 980),
+  P_JUMP(0)
 };
 
-const SetCommand changetheyear_commands[] =
-{
-  {COMMAND_NONE, 40, 40},
-  {COMMAND_LEFT, 40, 0},
-  {COMMAND_RS_LEFT, 40, 0},
-  {COMMAND_LEFT, 40, 0},
-  {COMMAND_RS_LEFT, 40, 0},
-  {COMMAND_LEFT, 40, 0},
-  {COMMAND_UP, 40, 0},
-  {COMMAND_RIGHT, 40, 0},
-  {COMMAND_RS_RIGHT, 40, 0},
-  {COMMAND_RIGHT, 40, 0},
-  {COMMAND_RS_RIGHT, 40, 0},
-  {COMMAND_RIGHT, 40, 40},
-  {COMMAND_A, 40, 160},
-  {COMMAND_A, 40, 160},
-  {COMMAND_LEFT, 40, 0},
-  {COMMAND_RS_LEFT, 40, 0},
-  {COMMAND_LEFT, 40, 0},
-  {COMMAND_RS_LEFT, 40, 0},
-  {COMMAND_LEFT, 40, 0},
-  {COMMAND_DOWN, 5400, 0},
-  {COMMAND_RIGHT, 40, 0},
-  {COMMAND_RS_RIGHT, 40, 0},
-  {COMMAND_RIGHT, 40, 0},
-  {COMMAND_RS_RIGHT, 40, 0},
-  {COMMAND_RIGHT, 40, 40},
-  {COMMAND_A, 40, 160},
-  {COMMAND_A, 40, 160},
-  {COMMAND_B, 40, 160},
-  {COMMAND_UP, 40, 160},
-  {COMMAND_A, 40, 160},
-  {COMMAND_NONE, 100, 700}
+static const PresetOp inf_watt_program[] = {
+  P_PRESS(COMMAND_A, 40, 960),
+  P_LOOP(5),
+    P_PRESS(COMMAND_B, 40, 1460),
+  P_ENDLOOP(),
+  P_PRESS(COMMAND_A, 40, 1460),
+  P_PRESS(COMMAND_A, 40, 3460),
+  P_PRESS(COMMAND_HOME, 100, 700),
+  P_CALL(SUB_SKIP_DAY),
+  P_PRESS(COMMAND_B, 40, 740),
+  P_PRESS(COMMAND_A, 40, 3440),
+  P_JUMP(0)
+};
+
+static const PresetOp pickupberry_program[] = {
+  P_PRESS(COMMAND_L, 40, 40),
+  P_LOOP(3),
+    P_PRESS(COMMAND_A, 40, 360),
+  P_ENDLOOP(),
+  P_LOOP(18),
+    P_PRESS(COMMAND_B, 40, 460),
+  P_ENDLOOP(),
+  P_PRESS(COMMAND_HOME, 100, 700),
+  P_CALL(SUB_SKIP_DAY),
+  P_JUMP(0)
+};
+
+// 年・月・日をそれぞれ1つ進めて終了
+static const PresetOp changethedate_program[] = {
+  P_PRESS(COMMAND_NONE, 40, 40),
+  P_CALL(SUB_OPEN_SETTINGS),
+  P_CALL(SUB_OPEN_DATETIME),
+  P_PRESS(COMMAND_UP, 40, 40),
+  P_PRESS(COMMAND_RIGHT, 40, 0),
+  P_PRESS(COMMAND_UP, 40, 40),
+  P_PRESS(COMMAND_RS_RIGHT, 40, 0),
+  P_PRESS(COMMAND_UP, 40, 40),
+  P_PRESS(COMMAND_RIGHT, 40, 0),
+  P_PRESS(COMMAND_RS_RIGHT, 40, 0),
+  P_PRESS(COMMAND_RIGHT, 40, 40),
+  P_PRESS(COMMAND_A, 40, 310),
+  P_PRESS(COMMAND_HOME, 100, 700),
+  P_PRESS(COMMAND_NONE, 100, 700),
+  P_HALT()
+};
+
+static const PresetOp changetheyear_program[] = {
+  P_PRESS(COMMAND_NONE, 40, 40),
+  P_LOOP(2),
+    P_PRESS(COMMAND_LEFT, 40, 0),
+    P_PRESS(COMMAND_RS_LEFT, 40, 0),
+  P_ENDLOOP(),
+  P_PRESS(COMMAND_LEFT, 40, 0),
+  P_PRESS(COMMAND_UP, 40, 0),
+  P_LOOP(2),
+    P_PRESS(COMMAND_RIGHT, 40, 0),
+    P_PRESS(COMMAND_RS_RIGHT, 40, 0),
+  P_ENDLOOP(),
+  P_PRESS(COMMAND_RIGHT, 40, 40),
+  P_LOOP(2),
+    P_PRESS(COMMAND_A, 40, 160),
+  P_ENDLOOP(),
+  P_LOOP(2),
+    P_PRESS(COMMAND_LEFT, 40, 0),
+    P_PRESS(COMMAND_RS_LEFT, 40, 0),
+  P_ENDLOOP(),
+  P_PRESS(COMMAND_LEFT, 40, 0),
+  P_PRESS(COMMAND_DOWN, 5400, 0),
+  P_LOOP(2),
+    P_PRESS(COMMAND_RIGHT, 40, 0),
+    P_PRESS(COMMAND_RS_RIGHT, 40, 0),
+  P_ENDLOOP(),
+  P_PRESS(COMMAND_RIGHT, 40, 40),
+  P_LOOP(2),
+    P_PRESS(COMMAND_A, 40, 160),
+  P_ENDLOOP(),
+  P_PRESS(COMMAND_B, 40, 160),
+  P_PRESS(COMMAND_UP, 40, 160),
+  P_PRESS(COMMAND_A, 40, 160),
+  P_PRESS(COMMAND_NONE, 100, 700),
+  P_HALT()
+};
+
+// ProcessState ごとのプログラム（プリセット以外は nullptr）
+static const PresetOp* const preset_programs[PRESET_USER + 1] = {
+  nullptr,                 // PRESET_NONE
+  nullptr,                 // PC_CALL
+  nullptr,                 // PC_CALL_STRING
+  nullptr,                 // PC_CALL_KEYBOARD
+  nullptr,                 // PC_CALL_KEYBOARD_PRESS
+  nullptr,                 // PC_CALL_KEYBOARD_RELEASE
+  mash_a_program,          // MASH_A
+  aaabb_program,           // AAABB
+  auto_league_program,     // AUTO_LEAGUE
+  inf_watt_program,        // INF_WATT
+  pickupberry_program,     // PICKUPBERRY
+  changethedate_program,   // CHANGETHEDATE
+  changetheyear_program,   // CHANGETHEYEAR
+  nullptr,                 // PRESET_USER（開始時に指定）
 };
 
-// ==========================================
-// コマンド配列サイズ
-// ==========================================
-const int mash_a_size = (int)(sizeof(mash_a_commands) / sizeof(SetCommand));
-const int aaabb_size = (int)(sizeof(aaabb_commands) / sizeof(SetCommand));
-const int auto_league_size = (int)(sizeof(auto_league_commands) / sizeof(SetCommand));
-const int inf_watt_size = (int)(sizeof(inf_watt_commands) / sizeof(SetCommand));
-const int pickupberry_size = (int)(sizeof(pickupberry_commands) / sizeof(SetCommand));
-const int changethedate_size = (int)(sizeof(changethedate_commands) / sizeof(SetCommand));
-const int changetheyear_size = (int)(sizeof(changetheyear_commands) / sizeof(SetCommand));
 
 // ==========================================
 // ApplyButtonCommand - コマンドをレポートに適用
 // ==========================================
-switch_report_t ApplyButtonCommand(const SetCommand* commands, switch_report_t ReportData)
+switch_report_t ApplyButtonCommand(uint8_t button, switch_report_t ReportData)
 {
-  uint8_t button = commands[cnt_command].command;
   switch (button)
   {
     case COMMAND_UP:
-      gp_report.ly = STICK_MIN;
+      ReportData.ly = STICK_MIN;
       break;
 
     case COMMAND_LEFT:
-      gp_report.lx = STICK_MIN;
+      ReportData.lx = STICK_MIN;
       break;
 
     case COMMAND_DOWN:
-      gp_report.ly = STICK_MAX;
+      ReportData.ly = STICK_MAX;
       break;
 
     case COMMAND_RIGHT:
-      gp_report.lx = STICK_MAX;
+      ReportData.lx = STICK_MAX;
       break;
 
     case COMMAND_A:
-      gp_report.buttons |= BUTTON_A;
+      ReportData.buttons |= BUTTON_A;
       break;
 
     case COMMAND_B:
-      gp_report.buttons |= BUTTON_B;
+      ReportData.buttons |= BUTTON_B;
       break;
 
     case COMMAND_X:
-      gp_report.buttons |= BUTTON_X;
+      ReportData.buttons |= BUTTON_X;
       break;
 
     case COMMAND_Y:
-      gp_report.buttons |= BUTTON_Y;
+      ReportData.buttons |= BUTTON_Y;
       break;
 
     case COMMAND_L:
-      gp_report.buttons |= BUTTON_L;
+      ReportData.buttons |= BUTTON_L;
       break;
 
     case COMMAND_R:
-      gp_report.buttons |= BUTTON_R;
+      ReportData.buttons |= BUTTON_R;
       break;
 
     case COMMAND_ZL:
-      gp_report.buttons |= BUTTON_ZL;
+      ReportData.buttons |= BUTTON_ZL;
       break;
 
     case COMMAND_ZR:
-      gp_report.buttons |= BUTTON_ZR;
+      ReportData.buttons |= BUTTON_ZR;
       break;
 
     case COMMAND_TRIGGERS:
-      gp_report.buttons |= BUTTON_L | BUTTON_R;
+      ReportData.buttons |= BUTTON_L | BUTTON_R;
       break;
 
     case COMMAND_UPLEFT:
-      gp_report.lx = STICK_MIN;
-      gp_report.ly = STICK_MIN;
+      ReportData.lx = STICK_MIN;
+      ReportData.ly = STICK_MIN;
       break;
 
     case COMMAND_UPRIGHT:
-      gp_report.lx = STICK_MAX;
-      gp_report.ly = STICK_MIN;
+      ReportData.lx = STICK_MAX;
+      ReportData.ly = STICK_MIN;
       break;
 
     case COMMAND_DOWNRIGHT:
-      gp_report.lx = STICK_MAX;
-      gp_report.ly = STICK_MAX;
+      ReportData.lx = STICK_MAX;
+      ReportData.ly = STICK_MAX;
       break;
 
     case COMMAND_DOWNLEFT:
-      gp_report.lx = STICK_MIN;
-      gp_report.ly = STICK_MAX;
+      ReportData.lx = STICK_MIN;
+      ReportData.ly = STICK_MAX;
       break;
 
     case COMMAND_PLUS:
-      gp_report.buttons |= BUTTON_PLUS;
+      ReportData.buttons |= BUTTON_PLUS;
       break;
 
     case COMMAND_MINUS:
-      gp_report.buttons |= BUTTON_MINUS;
+      ReportData.buttons |= BUTTON_MINUS;
       break;
 
     case COMMAND_HOME:
-      gp_report.buttons |= BUTTON_HOME;
+      ReportData.buttons |= BUTTON_HOME;
       break;
 
     case COMMAND_CAPTURE:
-      gp_report.buttons |= BUTTON_CAPTURE;
+      ReportData.buttons |= BUTTON_CAPTURE;
       break;
 
     case COMMAND_RS_UP:
-      gp_report.ry = STICK_MIN;
+      ReportData.ry = STICK_MIN;
       break;
 
     case COMMAND_RS_LEFT:
-      gp_report.rx = STICK_MIN;
+      ReportData.rx = STICK_MIN;
       break;
 
     case COMMAND_RS_DOWN:
-      gp_report.ry = STICK_MAX;
+      ReportData.ry = STICK_MAX;
       break;
 
     case COMMAND_RS_RIGHT:
-      gp_report.rx = STICK_MAX;
+      ReportData.rx = STICK_MAX;
       break;
 
     case COMMAND_RS_UPLEFT:
-      gp_report.rx = STICK_MIN;
-      gp_report.ry = STICK_MIN;
+      ReportData.rx = STICK_MIN;
+      ReportData.ry = STICK_MIN;
       break;
 
     case COMMAND_RS_UPRIGHT:
-      gp_report.rx = STICK_MAX;
-      gp_report.ry = STICK_MIN;
+      ReportData.rx = STICK_MAX;
+      ReportData.ry = STICK_MIN;
       break;
 
     case COMMAND_RS_DOWNRIGHT:
-      gp_report.rx = STICK_MAX;
-      gp_report.ry = STICK_MAX;
+      ReportData.rx = STICK_MAX;
+      ReportData.ry = STICK_MAX;
       break;
 
     case COMMAND_RS_DOWNLEFT:
-      gp_report.rx = STICK_MIN;
-      gp_report.ry = STICK_MAX;
+      ReportData.rx = STICK_MIN;
+      ReportData.ry = STICK_MAX;
       break;
 
     case COMMAND_HAT_TOP:
-      gp_report.hat = HAT_UP;
+      ReportData.hat = HAT_UP;
       break;
 
     case COMMAND_HAT_TOP_RIGHT:
-      gp_report.hat = HAT_UP_RIGHT;
+      ReportData.hat = HAT_UP_RIGHT;
       break;
 
     case COMMAND_HAT_RIGHT:
-      gp_report.hat = HAT_RIGHT;
+      ReportData.hat = HAT_RIGHT;
       break;
 
     case COMMAND_HAT_BOTTOM_RIGHT:
-      gp_report.hat = HAT_DOWN_RIGHT;
+      ReportData.hat = HAT_DOWN_RIGHT;
       break;
 
     case COMMAND_HAT_BOTTOM:
-      gp_report.hat = HAT_DOWN;
+      ReportData.hat = HAT_DOWN;
       break;
 
     case COMMAND_HAT_BOTTOM_LEFT:
-      gp_report.hat = HAT_DOWN_LEFT;
+      ReportData.hat = HAT_DOWN_LEFT;
       break;
 
     case COMMAND_HAT_LEFT:
-      gp_report.hat = HAT_LEFT;
+      ReportData.hat = HAT_LEFT;
       break;
 
     case COMMAND_HAT_TOP_LEFT:
-      gp_report.hat = HAT_UP_LEFT;
+      ReportData.hat = HAT_UP_LEFT;
       break;
 
     case COMMAND_NONE:
@@ -466,180 +459,108 @@ switch_report_t ApplyButtonCommand(const SetCommand* commands, switch_report_t R
 }
 
 // ==========================================
-// GetNextReportFromCommands - コマンド列実行（汎用）
+// インタプリタ
 // ==========================================
-void GetNextReportFromCommands(const SetCommand* commands, const int step_size)
-{
-  if ((blduration == false) && (blwaittime == false))
-  {
-    memcpy(&last_pc_report, &gp_report, sizeof(switch_report_t));
-    ApplyButtonCommand(commands, gp_report);
-    sendReportOnly(gp_report);
-    s_ultime = millis();
-    blduration = true;
-    blwaittime = true;
-    return;
-  }
-  else if ((blduration == true) && (blwaittime == true))
-  {
-    if (millis() - s_ultime > (unsigned long)commands[cnt_command].duration)
-    {
-      sendReportOnly(last_pc_report);
-      s_ultime = millis();
-      blduration = false;
-    }
-    return;
-  }
-  else
-  {
-    if (millis() - s_ultime > (unsigned long)commands[cnt_command].waittime)
-    {
-      memcpy(&gp_report, &last_pc_report, sizeof(switch_report_t));
-      cnt_command++;
-      if (cnt_command >= step_size)
-      {
-        cnt_command = 0;
-      }
-      blduration = false;
-      blwaittime = false;
-    }
-  }
+
+/**
+ * プログラム実行を終了（HALT またはスタック異常）
+ */
+static void halt_program(void) {
+  s_root_program = nullptr;
+  s_program = nullptr;
+  s_current = nullptr;
+  s_phase = PHASE_FETCH;
+  proc_state = PRESET_NONE;
 }
 
-// ==========================================
-// GetNextReportFromCommandsforChangeTheDate - 日付変更コマンド実行
-// ==========================================
-void GetNextReportFromCommandsforChangeTheDate(const SetCommand* commands, const int step_size)
+/**
+ * 1ステップ実行
+ * 制御命令（LOOP/CALL/JUMP など）は同じ呼び出し内で連続して処理し、
+ * PRESS に到達するか時間待ちになった時点で戻る
+ */
+static void run_program(void)
 {
-  if ((blduration == false) && (blwaittime == false))
-  {
-    memcpy(&last_pc_report, &gp_report, sizeof(switch_report_t));
-    ApplyButtonCommand(commands, gp_report);
-    sendReportOnly(gp_report);
-    s_ultime = millis();
-    blduration = true;
-    blwaittime = true;
-    return;
-  }
-  else if ((blduration == true) && (blwaittime == true))
-  {
-    if (millis() - s_ultime > (unsigned long)commands[cnt_command].duration)
-    {
-      sendReportOnly(last_pc_report);
-      s_ultime = millis();
-      blduration = false;
-    }
-    return;
-  }
-  else
+  for (int guard = 0; guard < PRESET_MAX_CONTROL_OPS; guard++)
   {
-    if (millis() - s_ultime > (unsigned long)commands[cnt_command].waittime)
+    if (s_phase == PHASE_PRESS)
     {
-      memcpy(&gp_report, &last_pc_report, sizeof(switch_report_t));
-      cnt_command++;
-      if(cnt_command >= step_size)
-      {
-        cnt_command = step_size - 1;
-      }
-      if((cnt_command == INDEX_ARRAY_YEAR + 1) && (YearChangeCnt > 1))
-      {
-        YearChangeCnt--;
-        cnt_command = INDEX_ARRAY_YEAR;
-      }
-      if(cnt_command == INDEX_ARRAY_YEAR)
-      {
-        YearChangeCnt++;
-        cnt_command++;
-      }
-      if((cnt_command == INDEX_ARRAY_MONTH + 1) && (MonthChangeCnt > 1))
-      {
-        MonthChangeCnt--;
-        cnt_command = INDEX_ARRAY_MONTH;
-      }
-      if(cnt_command == INDEX_ARRAY_MONTH)
-      {
-        MonthChangeCnt++;
-        cnt_command++;
-      }
-      if((cnt_command == INDEX_ARRAY_DAY + 1) && (DayChangeCnt > 1))
-      {
-        DayChangeCnt--;
-        cnt_command = INDEX_ARRAY_DAY;
-      }
-      if(cnt_command == INDEX_ARRAY_DAY)
-      {
-        DayChangeCnt++;
-        cnt_command++;
-      }
-      blduration = false;
-      blwaittime = false;
+      if (!phaseDue()) return;
+      *s_report = last_pc_report;
+      schedulePhase(s_current->waittime);
+      s_phase = PHASE_WAIT;
+      continue;
     }
-  }
-}
 
-// ==========================================
-// GetNextReportFromCommandsforChangeTheYear - 年変更コマンド実行
-// ==========================================
-void GetNextReportFromCommandsforChangeTheYear(const SetCommand* commands, const int step_size)
-{
-  if ((blduration == false) && (blwaittime == false))
-  {
-    memcpy(&last_pc_report, &gp_report, sizeof(switch_report_t));
-    ApplyButtonCommand(commands, gp_report);
-    sendReportOnly(gp_report);
-    s_ultime = millis();
-    blduration = true;
-    blwaittime = true;
-    return;
-  }
-  else if ((blduration == true) && (blwaittime == true))
-  {
-    if (millis() - s_ultime > (unsigned long)commands[cnt_command].duration)
+    if (s_phase == PHASE_WAIT)
     {
-      sendReportOnly(last_pc_report);
-      s_ultime = millis();
-      blduration = false;
+      if (!phaseDue()) return;
+      *s_report = last_pc_report;
+      s_pc++;
+      s_phase = PHASE_FETCH;
+      continue;
     }
-    return;
-  }
-  else
-  {
-    if (millis() - s_ultime > (unsigned long)commands[cnt_command].waittime)
+
+    const PresetOp* op = &s_program[s_pc];
+    switch (op->op)
     {
-      memcpy(&gp_report, &last_pc_report, sizeof(switch_report_t));
-      cnt_command++;
-      if ((YearChangeCnt > 0) && (cnt_command == 14))
-      {
-        if (step_size_buf == INT8_MAX)
-        {
-          step_size_buf = cnt_command;
-        }
-        cnt_command = 27;
-      }
-      else if ((YearChangeCnt > 0) && (cnt_command == 27))
-      {
-        YearChangeCnt--;
-        if (YearChangeCnt > 0)
-        {
-          cnt_command = 1;
-        }
-        else
-        {
-          cnt_command++;
+      case OP_PRESS:
+        last_pc_report = *s_report;
+        *s_report = ApplyButtonCommand(op->arg, *s_report);
+        s_current = op;
+        resyncIfLate();
+        schedulePhase(op->duration);
+        s_phase = PHASE_PRESS;
+        return;
+
+      case OP_LOOP:
+        if (loop_depth >= PRESET_LOOP_DEPTH) { halt_program(); return; }
+        loop_stack[loop_depth].start_pc = s_pc + 1;
+        loop_stack[loop_depth].remaining = op->arg;
+        loop_depth++;
+        s_pc++;
+        break;
+
+      case OP_ENDLOOP:
+        if (loop_depth == 0) { halt_program(); return; }
+        if (loop_stack[loop_depth - 1].remaining > 1) {
+          loop_stack[loop_depth - 1].remaining--;
+          s_pc = loop_stack[loop_depth - 1].start_pc;
+        } else {
+          loop_depth--;
+          s_pc++;
         }
-      }
-      else if ((YearChangeCnt == 0) && (cnt_command > step_size_buf - 1))
-      {
-        cnt_command = step_size_buf - 1;
-      }
-      else if ((YearChangeCnt == 0) && (cnt_command == step_size_buf - 1))
-      {
-        proc_state = PRESET_NONE;
-        cnt_command = 0;
-        step_size_buf = INT8_MAX;
-      }
-      blduration = false;
-      blwaittime = false;
+        break;
+
+      case OP_CALL:
+        if (call_depth >= PRESET_CALL_DEPTH || op->arg >= SUB_COUNT) { halt_program(); return; }
+        call_stack[call_depth].program = s_program;
+        call_stack[call_depth].pc = s_pc + 1;
+        call_depth++;
+        s_program = preset_subroutines[op->arg];
+        s_pc = 0;
+        break;
+
+      case OP_RET:
+        if (call_depth == 0) { halt_program(); return; }
+        call_depth--;
+        s_program = call_stack[call_depth].program;
+        s_pc = call_stack[call_depth].pc;
+        break;
+
+      case OP_JUMP:
+        s_pc = op->arg;
+        break;
+
+      case OP_LSTICK:
+        s_report->lx = op->arg;
+        s_report->ly = (uint8_t)op->duration;
+        s_pc++;
+        break;
+
+      case OP_HALT:
+      default:
+        halt_program();
+        return;
     }
   }
 }
@@ -649,113 +570,69 @@ void GetNextReportFromCommandsforChangeTheYear(const SetCommand* commands, const
 // ==========================================
 void SwitchFunction(void)
 {
-  switch (proc_state)
-  {
-    case PRESET_NONE:
-    case PC_CALL:
-      sendReportOnly(gp_report);
-      break;
-
-    case PC_CALL_STRING:
-      // TODO: キーボード文字列入力実装
-      break;
-
-    case PC_CALL_KEYBOARD:
-    case PC_CALL_KEYBOARD_PRESS:
-    case PC_CALL_KEYBOARD_RELEASE:
-      // TODO: キーボード特殊キー実装
-      break;
-
-    case MASH_A:
-      GetNextReportFromCommands(&mash_a_commands[0], mash_a_size);
-      break;
-
-    case AAABB:
-      GetNextReportFromCommands(&aaabb_commands[0], aaabb_size);
-      break;
-
-    case AUTO_LEAGUE:
-      gp_report.lx = 172;
-      gp_report.ly = 7;
-      GetNextReportFromCommands(&auto_league_commands[0], auto_league_size);
-      break;
+  if (s_program != nullptr) {
+    run_program();
+  }
+}
 
-    case INF_WATT:
-      GetNextReportFromCommands(&inf_watt_commands[0], inf_watt_size);
-      break;
+// ==========================================
+// 互換性のための旧関数実装
+// ==========================================
 
-    case PICKUPBERRY:
-      GetNextReportFromCommands(&pickupberry_commands[0], pickupberry_size);
-      break;
+/**
+ * プリセット開始（実行状態を初期化）
+ */
+static void start_preset(ProcessState state, const PresetOp* program) {
+  proc_state = state;
+  s_root_program = program;
+  s_program = program;
+  s_current = nullptr;
+  s_pc = 0;
+  s_phase = PHASE_FETCH;
+  call_depth = 0;
+  loop_depth = 0;
+  s_origin_us = time_us_64();
+  s_planned_us = 0;
+  memset(&s_timing, 0, sizeof(s_timing));
+  s_timing.state = (uint8_t)state;
+}
 
-    case CHANGETHEDATE:
-      GetNextReportFromCommandsforChangeTheDate(&changethedate_commands[0], changethedate_size);
-      break;
+void get_preset_timing(PresetTimingStats* stats) {
+  *stats = s_timing;
+}
 
-    case CHANGETHEYEAR:
-      GetNextReportFromCommandsforChangeTheYear(&changetheyear_commands[0], changetheyear_size);
-      break;
+void start_builtin_preset(ProcessState state) {
+  // 実際の開始は送信側（core1）で行う
+  s_requested_program = preset_programs[state];
+  s_requested_state = (int)state;
+}
 
-    default:
-      break;
-  }
+void start_user_preset(const PresetOp* program) {
+  s_requested_program = program;
+  s_requested_state = (int)PRESET_USER;
 }
 
-// ==========================================
-// 互換性のための旧関数実装
-// ==========================================
+void stop_preset(void) {
+  s_requested_program = nullptr;
+  s_requested_state = (int)PRESET_NONE;
+}
 
-void parse_preset_command(const char* cmd) {
-  if (strcmp(cmd, "mash_a") == 0) {
-    proc_state = MASH_A;
-    cnt_command = 0;
-    blduration = false;
-    blwaittime = false;
-  }
-  else if (strcmp(cmd, "aaabb") == 0) {
-    proc_state = AAABB;
-    cnt_command = 0;
-    blduration = false;
-    blwaittime = false;
-  }
-  else if (strcmp(cmd, "auto_league") == 0) {
-    proc_state = AUTO_LEAGUE;
-    cnt_command = 0;
-    blduration = false;
-    blwaittime = false;
-  }
-  else if (strcmp(cmd, "inf_watt") == 0) {
-    proc_state = INF_WATT;
-    cnt_command = 0;
-    blduration = false;
-    blwaittime = false;
-  }
-  else if (strcmp(cmd, "pickupberry") == 0) {
-    proc_state = PICKUPBERRY;
-    cnt_command = 0;
-    blduration = false;
-    blwaittime = false;
-  }
-  else if (strcmp(cmd, "changethedate") == 0) {
-    proc_state = CHANGETHEDATE;
-    cnt_command = 0;
-    blduration = false;
-    blwaittime = false;
-    YearChangeCnt = 0;
-    MonthChangeCnt = 0;
-    DayChangeCnt = 0;
-    step_size_buf = INT8_MAX;
-  }
-  else if (strcmp(cmd, "changetheyear") == 0) {
-    proc_state = CHANGETHEYEAR;
-    cnt_command = 0;
-    blduration = false;
-    blwaittime = false;
-    YearChangeCnt = 0;
-    step_size_buf = INT8_MAX;
-  }
+bool preset_program_in_use(const PresetOp* program) {
+  // core1 は s_root_program を設定してから要求を消すため、この順で読めば取りこぼさない
+  if (s_requested_state >= 0 && s_requested_program == program) return true;
+  return s_root_program == program;
 }
 
-void update_preset_state(void) {
+bool update_preset_state(switch_report_t* report) {
+  s_report = report;
+  int requested = s_requested_state;
+  if (requested >= 0) {
+    // 押下中・解放待ち中に止めた場合は押す前の状態へ戻す（ボタンを押しっぱなしにしない）
+    if (s_phase == PHASE_PRESS || s_phase == PHASE_WAIT) *s_report = last_pc_report;
+    start_preset((ProcessState)requested, s_requested_program);
+    s_requested_state = -1;
+  }
+  switch_report_t before = *report;
   SwitchFunction();
+  return memcmp(&before, report, sizeof(before)) != 0;
 }
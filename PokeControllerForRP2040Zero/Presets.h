@@ -2,6 +2,7 @@
  * Presets.h - プリセットコマンド定義（Pico互換方式）
  * v1.4.0: プリセットコマンド機能追加
  * v1.5.0: Pico互換コマンドシステム実装、日付変更コマンドを固定プリセット方式に変更
+ * v1.6.0: プリセットを6バイト命令のバイトコードに変更（PresetOp）、Flash 保存プリセットの実行
  */
 
 #ifndef PRESETS_H
@@ -10,10 +11,13 @@
 #include <Arduino.h>
 #include "Common.h"
 
-// 日付変更用インデックス定義
-#define INDEX_ARRAY_YEAR  (30)
-#define INDEX_ARRAY_MONTH (32)
-#define INDEX_ARRAY_DAY   (34)
+// インタプリタのスタック深さ
+#define PRESET_CALL_DEPTH       4
+#define PRESET_LOOP_DEPTH       4
+// 1回の呼び出しで連続処理する制御命令の上限（無限ループ対策）
+#define PRESET_MAX_CONTROL_OPS  16
+// 押下開始がこれ以上遅れたら期限の基準を合わせ直す（押下時間を削らないため）
+#define PRESET_RESYNC_US        20000
 
 // ==========================================
 // ループステート列挙型
@@ -94,29 +98,46 @@ typedef enum {
   PICKUPBERRY,          // ベリー収集
   CHANGETHEDATE,        // 日付変更
   CHANGETHEYEAR,        // 年変更
+  PRESET_USER,          // v1.6.0: Flash に保存したプリセット
 } ProcessState;
 
 // ==========================================
-// コマンド配列宣言
+// v1.6.0: プリセット命令（バイトコード）
 // ==========================================
-extern const SetCommand mash_a_commands[];
-extern const SetCommand aaabb_commands[];
-extern const SetCommand auto_league_commands[];
-extern const SetCommand inf_watt_commands[];
-extern const SetCommand pickupberry_commands[];
-extern const SetCommand changethedate_commands[];
-extern const SetCommand changetheyear_commands[];
-
-// ==========================================
-// コマンド配列サイズ
-// ==========================================
-extern const int mash_a_size;
-extern const int aaabb_size;
-extern const int auto_league_size;
-extern const int inf_watt_size;
-extern const int pickupberry_size;
-extern const int changethedate_size;
-extern const int changetheyear_size;
+typedef enum {
+  OP_HALT = 0,   // 実行終了（PRESET_NONE に戻る）
+  OP_PRESS,      // arg のボタンを duration ms 押し、離して waittime ms 待つ
+  OP_LOOP,       // ENDLOOP までを arg 回繰り返す（1以上）
+  OP_ENDLOOP,
+  OP_CALL,       // arg 番のサブルーチンを呼ぶ
+  OP_RET,
+  OP_JUMP,       // arg 番目の命令へジャンプ
+  OP_LSTICK      // 左スティックを固定（lx = arg, ly = duration）
+} PresetOpCode;
+
+typedef struct {
+  uint8_t  op;        // PresetOpCode
+  uint8_t  arg;       // BUTTON_DEFINE / 回数 / サブルーチン番号 / ジャンプ先
+  uint16_t duration;  // 操作時間（ミリ秒）
+  uint16_t waittime;  // 操作後の待ち時間（ミリ秒）
+} PresetOp;
+
+#define P_PRESS(cmd, dur, wait) { OP_PRESS, (uint8_t)(cmd), (dur), (wait) }
+#define P_LOOP(n)               { OP_LOOP, (n), 0, 0 }
+#define P_ENDLOOP()             { OP_ENDLOOP, 0, 0, 0 }
+#define P_CALL(sub)             { OP_CALL, (sub), 0, 0 }
+#define P_RET()                 { OP_RET, 0, 0, 0 }
+#define P_JUMP(pc)              { OP_JUMP, (pc), 0, 0 }
+#define P_LSTICK(x, y)          { OP_LSTICK, (x), (y), 0 }
+#define P_HALT()                { OP_HALT, 0, 0, 0 }
+
+// 組み込みサブルーチン番号（OP_CALL の引数、保存プリセットからも呼び出し可）
+enum {
+  SUB_OPEN_SETTINGS = 0,  // HOME → 設定 → 本体メニューまでスクロール
+  SUB_OPEN_DATETIME,      // 本体 → 日付と時刻 → 現在の日付と時刻
+  SUB_SKIP_DAY,           // 日付を1日進めて HOME に戻る（inf_watt / pickupberry 共通）
+  SUB_COUNT
+};
 
 // ==========================================
 // 外部関数宣言
@@ -125,16 +146,32 @@ extern const int changetheyear_size;
 // ステートマシン実行
 void SwitchFunction(void);
 
-// コマンド適用
-switch_report_t ApplyButtonCommand(const SetCommand* commands, switch_report_t ReportData);
-
-// コマンド列実行（汎用）
-void GetNextReportFromCommands(const SetCommand* commands, const int step_size);
-void GetNextReportFromCommandsforChangeTheDate(const SetCommand* commands, const int step_size);
-void GetNextReportFromCommandsforChangeTheYear(const SetCommand* commands, const int step_size);
+// コマンド適用（button を ReportData に反映して返す）
+switch_report_t ApplyButtonCommand(uint8_t button, switch_report_t ReportData);
 
 // 互換性のための旧関数宣言
-void parse_preset_command(const char* cmd);
-void update_preset_state(void);
+// v1.6.0: プリセット名の判定はメインファイルのキーワード表で行う
+// v1.6.0: プリセットの開始・停止（実際の切り替えは core1 で行う）
+void start_builtin_preset(ProcessState state);
+void start_user_preset(const PresetOp* program);
+void stop_preset(void);
+// v1.6.0: program が実行中または開始待ちなら true（書き換え前の確認用）
+bool preset_program_in_use(const PresetOp* program);
+// v1.6.0: report はプリセットが操作するレポート（core1 の送信用レポート）
+// プリセットが report を変更した場合 true
+bool update_preset_state(switch_report_t* report);
+
+// v1.6.0: 実行中（または最後に実行した）プリセットの計画時間と実測の比較
+typedef struct {
+  uint8_t  state;         // ProcessState
+  uint32_t steps;         // 終了したフェーズ数
+  uint64_t planned_us;    // 最後のフェーズ終了までの計画時間（開始から）
+  uint64_t actual_us;     // 同、実測時間
+  uint64_t late_sum_us;   // 期限からの遅れの合計
+  uint32_t late_max_us;   // 同、最大
+  uint32_t resyncs;       // 基準を合わせ直した回数
+} PresetTimingStats;
+
+void get_preset_timing(PresetTimingStats* stats);
 
 #endif // PRESETS_H
@@ -0,0 +1,420 @@
+/**
+ * Replay.cpp - PC 入力の記録と再生の実装
+ *
+ * 1件の形式: 経過時間（us、LEB128 可変長） + 変化マスク（1バイト） + 変化したフィールド
+ * マスク 0 は1周の終わり（経過時間は最後の変化から記録終了まで）。
+ * 記録は中立状態から始まり、再生も各周の先頭で中立状態に戻してから適用する。
+ */
+
+#include "Replay.h"
+#include <LittleFS.h>
+#include <hardware/sync.h>
+#include <pico/time.h>
+
+// 変化マスク
+#define REC_F_BUTTONS  0x01
+#define REC_F_HAT      0x02
+#define REC_F_LX       0x04
+#define REC_F_LY       0x08
+#define REC_F_RX       0x10
+#define REC_F_RY       0x20
+#define REC_F_ALL      0x3F
+
+#define REC_EVENT_MAX  13   // 経過時間5 + マスク1 + フィールド7
+static const uint8_t REPLAY_MAGIC[4] = {'R', 'P', 'L', '1'};
+
+static const switch_report_t neutral_report = {
+  0, HAT_CENTER, STICK_CENTER, STICK_CENTER, STICK_CENTER, STICK_CENTER, 0
+};
+
+static uint8_t  buf[REPLAY_BUFFER_SIZE];
+static uint32_t buf_len = 0;          // 完成した記録の長さ（0: なし）
+static uint32_t buf_events = 0;
+static uint32_t buf_duration_us = 0;
+
+// 記録中の状態（core0）
+static bool     rec_active = false;
+static bool     rec_started = false;  // 最初の変化を記録済み
+static uint32_t rec_len = 0;
+static uint32_t rec_last_us = 0;
+static uint64_t rec_total_us = 0;
+static switch_report_t rec_last;
+
+// core0 → core1 の要求
+typedef enum { REPLAY_REQ_NONE = 0, REPLAY_REQ_START, REPLAY_REQ_STOP } ReplayRequest;
+static volatile uint8_t s_request = REPLAY_REQ_NONE;
+static volatile uint32_t s_req_loops = 0;
+
+// 再生中の状態（core1）
+static volatile bool s_running = false;
+static uint32_t s_pos = 0;
+static uint64_t s_origin_us = 0;      // 現在の周の開始時刻
+static uint64_t s_planned_us = 0;     // 周の開始から処理済みの変化までの計画時間
+static volatile uint32_t s_pass = 0;
+static volatile uint32_t s_loops = 0;
+static volatile uint32_t s_late_max_us = 0;
+static volatile uint32_t s_resyncs = 0;
+
+// ==========================================
+// 符号化
+// ==========================================
+
+static uint32_t put_varint(uint8_t* p, uint32_t v) {
+  uint32_t n = 0;
+  while (v >= 0x80) {
+    p[n++] = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  p[n++] = (uint8_t)v;
+  return n;
+}
+
+// 終端を越える・5バイトを超える場合は false
+static bool get_varint(const uint8_t* p, uint32_t len, uint32_t* pos, uint32_t* out) {
+  uint32_t v = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    if (*pos >= len) return false;
+    uint8_t b = p[(*pos)++];
+    v |= (uint32_t)(b & 0x7F) << shift;
+    if ((b & 0x80) == 0) {
+      *out = v;
+      return true;
+    }
+  }
+  return false;
+}
+
+static uint8_t field_size(uint8_t mask) {
+  uint8_t n = (mask & REC_F_BUTTONS) ? 2 : 0;
+  for (uint8_t bit = REC_F_HAT; bit <= REC_F_RY; bit <<= 1) {
+    if (mask & bit) n++;
+  }
+  return n;
+}
+
+static uint32_t encode_event(uint8_t* p, uint32_t delta_us, const switch_report_t* prev,
+                             const switch_report_t* cur) {
+  uint8_t mask = 0;
+  if (cur->buttons != prev->buttons) mask |= REC_F_BUTTONS;
+  if (cur->hat != prev->hat) mask |= REC_F_HAT;
+  if (cur->lx != prev->lx) mask |= REC_F_LX;
+  if (cur->ly != prev->ly) mask |= REC_F_LY;
+  if (cur->rx != prev->rx) mask |= REC_F_RX;
+  if (cur->ry != prev->ry) mask |= REC_F_RY;
+
+  uint32_t n = put_varint(p, delta_us);
+  p[n++] = mask;
+  if (mask & REC_F_BUTTONS) {
+    p[n++] = (uint8_t)(cur->buttons & 0xFF);
+    p[n++] = (uint8_t)(cur->buttons >> 8);
+  }
+  if (mask & REC_F_HAT) p[n++] = cur->hat;
+  if (mask & REC_F_LX) p[n++] = cur->lx;
+  if (mask & REC_F_LY) p[n++] = cur->ly;
+  if (mask & REC_F_RX) p[n++] = cur->rx;
+  if (mask & REC_F_RY) p[n++] = cur->ry;
+  return n;
+}
+
+static void apply_fields(const uint8_t* p, uint8_t mask, switch_report_t* report) {
+  if (mask & REC_F_BUTTONS) {
+    report->buttons = (uint16_t)(p[0] | (p[1] << 8));
+    p += 2;
+  }
+  if (mask & REC_F_HAT) report->hat = *p++;
+  if (mask & REC_F_LX) report->lx = *p++;
+  if (mask & REC_F_LY) report->ly = *p++;
+  if (mask & REC_F_RX) report->rx = *p++;
+  if (mask & REC_F_RY) report->ry = *p++;
+}
+
+/**
+ * 記録全体を検証（終端マーカーでちょうど終わること）
+ * 成功時は変化数と1周の長さを返す
+ */
+static bool validate(const uint8_t* p, uint32_t len, uint32_t* events, uint32_t* duration_us) {
+  uint32_t pos = 0, count = 0;
+  uint64_t total = 0;
+  while (pos < len) {
+    uint32_t delta;
+    if (!get_varint(p, len, &pos, &delta) || pos >= len) return false;
+    uint8_t mask = p[pos++];
+    total += delta;
+    if (mask == 0) {
+      if (pos != len || count == 0 || total == 0 || total > UINT32_MAX) return false;
+      *events = count;
+      *duration_us = (uint32_t)total;
+      return true;
+    }
+    if ((mask & ~REC_F_ALL) != 0 || pos + field_size(mask) > len) return false;
+    pos += field_size(mask);
+    count++;
+  }
+  return false;
+}
+
+// ==========================================
+// 記録（core0）
+// ==========================================
+
+static bool replay_busy(void) {
+  return s_request == REPLAY_REQ_START || s_running;
+}
+
+void replay_begin(void) {
+  File f = LittleFS.open(REPLAY_FILE, "r");
+  if (!f) return;
+  uint8_t header[8];
+  uint32_t len = 0;
+  bool ok = f.read(header, sizeof(header)) == (int)sizeof(header) &&
+            memcmp(header, REPLAY_MAGIC, 4) == 0;
+  if (ok) {
+    len = header[4] | (header[5] << 8) | ((uint32_t)header[6] << 16) | ((uint32_t)header[7] << 24);
+    ok = len <= sizeof(buf) && f.read(buf, len) == (int)len &&
+         validate(buf, len, &buf_events, &buf_duration_us);
+  }
+  f.close();
+  if (!ok) {
+    Serial.println("Rec: skipped " REPLAY_FILE);
+    buf_len = 0;
+    return;
+  }
+  buf_len = len;
+}
+
+void replay_capture(const switch_report_t* report, uint32_t t_us) {
+  if (!rec_active || memcmp(report, &rec_last, sizeof(rec_last)) == 0) return;
+  if (!rec_started) {
+    // 最初の変化の時刻を周の開始とする（記録開始から最初の入力までの待ちは含めない）
+    rec_started = true;
+    rec_last_us = t_us;
+  }
+  // 終端マーカー分を残す
+  if (rec_len + REC_EVENT_MAX + 6 > sizeof(buf)) {
+    rec_active = false;
+    Serial.println("Error: rec buffer full, recording stopped (rec stop to save)");
+    return;
+  }
+  uint32_t delta = t_us - rec_last_us;
+  rec_len += encode_event(&buf[rec_len], delta, &rec_last, report);
+  rec_total_us += delta;
+  rec_last = *report;
+  rec_last_us = t_us;
+  buf_events++;
+}
+
+static void rec_start(void) {
+  if (replay_busy()) {
+    Serial.println("Error: replay running");
+    return;
+  }
+  buf_len = 0;
+  buf_events = 0;
+  buf_duration_us = 0;
+  rec_len = 0;
+  rec_total_us = 0;
+  rec_last = neutral_report;
+  rec_started = false;
+  rec_active = true;
+  Serial.println("Rec: recording");
+}
+
+static void rec_stop(void) {
+  if (!rec_started) {
+    rec_active = false;
+    Serial.println("Rec: nothing recorded");
+    return;
+  }
+  // 終端マーカー（最後の変化から停止までの時間を1周に含める）
+  // バッファ満杯で止まっていた場合も、満杯になった時点までを保存する
+  uint32_t tail = rec_active ? micros() - rec_last_us : 0;
+  rec_active = false;
+  if (rec_total_us + tail < 1000) tail = 1000 - (uint32_t)rec_total_us;   // 1周 0 us の空回りを防ぐ
+  rec_len += put_varint(&buf[rec_len], tail);
+  buf[rec_len++] = 0;
+  rec_total_us += tail;
+  buf_duration_us = rec_total_us > UINT32_MAX ? UINT32_MAX : (uint32_t)rec_total_us;
+  buf_len = rec_len;
+
+  uint8_t header[8];
+  memcpy(header, REPLAY_MAGIC, 4);
+  for (int i = 0; i < 4; i++) header[4 + i] = (uint8_t)(buf_len >> (8 * i));
+  File f = LittleFS.open(REPLAY_FILE, "w");
+  bool ok = f && f.write(header, sizeof(header)) == sizeof(header) &&
+            f.write(buf, buf_len) == buf_len;
+  if (f) f.close();
+  if (!ok) {
+    Serial.println("Error: rec write failed (kept in RAM)");
+  }
+  Serial.printf("Rec: saved events=%lu bytes=%lu duration=%lu ms\n",
+                (unsigned long)buf_events, (unsigned long)buf_len,
+                (unsigned long)(buf_duration_us / 1000));
+}
+
+// ==========================================
+// 再生（core1）
+// ==========================================
+
+void replay_stop(void) {
+  if (replay_busy()) s_request = REPLAY_REQ_STOP;
+}
+
+static void finish_pass(switch_report_t* report) {
+  *report = neutral_report;
+  s_pos = 0;
+  s_origin_us += s_planned_us;
+  s_planned_us = 0;
+  if (s_loops != 0 && s_pass >= s_loops) {
+    s_running = false;
+    return;
+  }
+  s_pass++;
+}
+
+bool replay_update(switch_report_t* report) {
+  bool changed = false;
+  uint8_t req = s_request;
+  if (req == REPLAY_REQ_START) {
+    s_pos = 0;
+    s_origin_us = time_us_64();
+    s_planned_us = 0;
+    s_pass = 1;
+    s_loops = s_req_loops;
+    s_late_max_us = 0;
+    s_resyncs = 0;
+    *report = neutral_report;
+    changed = true;
+    s_running = true;
+    s_request = REPLAY_REQ_NONE;
+  } else if (req == REPLAY_REQ_STOP) {
+    if (s_running) {
+      *report = neutral_report;
+      changed = true;
+    }
+    s_running = false;
+    s_request = REPLAY_REQ_NONE;
+  }
+
+  // 期限を過ぎた変化をまとめて適用（期限は周の開始からの計画時間で決める）
+  uint64_t now = time_us_64();
+  while (s_running) {
+    uint32_t pos = s_pos;
+    uint32_t delta = 0;
+    if (!get_varint(buf, buf_len, &pos, &delta) || pos >= buf_len) {
+      // 記録が途中で切れている場合は、終端と同じく中立に戻して止める
+      *report = neutral_report;
+      s_running = false;
+      changed = true;
+      break;
+    }
+    uint64_t deadline = s_origin_us + s_planned_us + delta;
+    if (now < deadline) break;
+
+    uint32_t late = (uint32_t)(now - deadline);
+    if (late > REPLAY_RESYNC_US) {
+      // Flash 書き込み中の停止などで大きく遅れたら、以降の間隔を保つため基準をずらす
+      s_origin_us += late;
+      s_resyncs++;
+    } else if (late > s_late_max_us) {
+      s_late_max_us = late;
+    }
+    s_planned_us += delta;
+
+    uint8_t mask = buf[pos++];
+    if (mask == 0) {
+      finish_pass(report);
+    } else {
+      apply_fields(&buf[pos], mask, report);
+      s_pos = pos + field_size(mask);
+    }
+    changed = true;
+  }
+  return changed;
+}
+
+void replay_get_status(ReplayStatus* status) {
+  status->recording = rec_active;
+  status->replaying = replay_busy();
+  status->events = buf_events;
+  status->bytes = rec_active ? rec_len : buf_len;
+  status->duration_ms = buf_duration_us / 1000;
+  status->pass = s_pass;
+  status->loops = s_loops;
+  status->late_max_us = s_late_max_us;
+  status->resyncs = s_resyncs;
+}
+
+// ==========================================
+// コマンド
+// ==========================================
+
+static void print_status(void) {
+  ReplayStatus st;
+  replay_get_status(&st);
+  if (st.recording) {
+    Serial.printf("Rec: recording events=%lu bytes=%lu/%u\n", (unsigned long)st.events,
+                  (unsigned long)st.bytes, (unsigned)REPLAY_BUFFER_SIZE);
+  } else if (st.replaying) {
+    char loops[12] = "inf";
+    if (st.loops != 0) snprintf(loops, sizeof(loops), "%lu", (unsigned long)st.loops);
+    Serial.printf("Replay: running pass=%lu/%s late_max=%lu us resyncs=%lu\n",
+                  (unsigned long)st.pass, loops,
+                  (unsigned long)st.late_max_us, (unsigned long)st.resyncs);
+  } else {
+    Serial.printf("Rec: idle events=%lu bytes=%lu duration=%lu ms\n", (unsigned long)st.events,
+                  (unsigned long)st.bytes, (unsigned long)st.duration_ms);
+  }
+}
+
+// rec / rec start / rec stop
+void parse_rec_command(const char* line) {
+  const char* sub = line[3] == ' ' ? &line[4] : "";
+  if (strcmp(sub, "start") == 0) {
+    rec_start();
+  } else if (strcmp(sub, "stop") == 0) {
+    if (rec_active || rec_started) rec_stop();
+    else Serial.println("Error: not recording");
+    rec_started = false;
+  } else if (sub[0] == '\0') {
+    print_status();
+  } else {
+    Serial.println("Error: rec start|stop");
+  }
+}
+
+// replay [回数] / replay stop / replay status（回数 0 は無限）
+void parse_replay_command(const char* line) {
+  const char* sub = line[6] == ' ' ? &line[7] : "";
+  if (strcmp(sub, "stop") == 0) {
+    replay_stop();
+    Serial.println("Replay: stopped");
+    return;
+  }
+  if (strcmp(sub, "status") == 0) {
+    print_status();
+    return;
+  }
+  char* endptr;
+  unsigned long loops = sub[0] ? strtoul(sub, &endptr, 10) : 1;
+  if (sub[0] && *endptr != '\0') {
+    Serial.println("Error: replay [loops]|stop|status");
+    return;
+  }
+  if (rec_active) {
+    Serial.println("Error: recording in progress");
+    return;
+  }
+  if (buf_len == 0) {
+    Serial.println("Error: no recording");
+    return;
+  }
+  if (replay_busy()) {
+    Serial.println("Error: replay running");
+    return;
+  }
+  s_req_loops = (uint32_t)loops;
+  __dmb();   // 記録内容を書き終えてから core1 へ要求を渡す
+  s_request = REPLAY_REQ_START;
+  Serial.printf("Replay: start loops=%lu events=%lu duration=%lu ms\n", loops,
+                (unsigned long)buf_events, (unsigned long)(buf_duration_us / 1000));
+}
@@ -0,0 +1,49 @@
+/**
+ * Replay.h - PC 入力の記録と本体での再生
+ * v1.6.0: PC から送った操作を Flash に保存し、PC なしで同じ操作を繰り返せるようにする
+ *
+ * 記録は core0（受信処理）、再生は core1（送信処理）で行う。
+ * 変化したフィールドだけを前回からの経過時間（us）と共に可変長で保存する。
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <Arduino.h>
+#include "Common.h"
+
+#define REPLAY_BUFFER_SIZE  16384          // 記録バッファ（バイト）
+#define REPLAY_FILE         "/replay.bin"  // 保存先（1件のみ）
+#define REPLAY_RESYNC_US    20000          // これ以上遅れたら基準を合わせ直す
+
+typedef struct {
+  bool     recording;
+  bool     replaying;
+  uint32_t events;        // 記録済みの変化数
+  uint32_t bytes;         // 使用バイト数
+  uint32_t duration_ms;   // 1周の長さ（記録終了時に確定）
+  uint32_t pass;          // 再生中の周回（1から）
+  uint32_t loops;         // 再生回数（0: 無限）
+  uint32_t late_max_us;   // 再生時の期限からの最大遅れ
+  uint32_t resyncs;
+} ReplayStatus;
+
+// 起動時に Flash から記録を読み込む（preset_store_begin() の後に呼ぶ）
+void replay_begin(void);
+
+// core0: PC 入力で変化した gp_report を記録（記録中でなければ何もしない）
+void replay_capture(const switch_report_t* report, uint32_t t_us);
+
+// core1: 再生を進める。report を変更した場合 true
+bool replay_update(switch_report_t* report);
+
+// core0: 再生停止を要求（'end' コマンドなど）
+void replay_stop(void);
+
+void replay_get_status(ReplayStatus* status);
+
+// "rec ..." / "replay ..." コマンドを処理
+void parse_rec_command(const char* line);
+void parse_replay_command(const char* line);
+
+#endif // REPLAY_H
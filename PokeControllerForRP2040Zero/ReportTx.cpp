@@ -0,0 +1,280 @@
+/**
+ * ReportTx.cpp - Gamepad レポート送信（core1）の実装
+ */
+
+#include "ReportTx.h"
+#include "SpscQueue.h"
+#include "Presets.h"
+#include "Benchmark.h"
+#include "LatencyStats.h"
+#include "Trace.h"
+#include "Replay.h"
+#include "Timeline.h"
+#include "Motion.h"
+#include "LoopProfiler.h"
+
+static constexpr uint32_t GAMEPAD_REPORT_INTERVAL_US = 8000;   // 固定間隔モード・キープアライブ間隔
+static constexpr uint32_t REPORT_MAX_RATE_HZ = 1000;           // setPollInterval(1) の上限
+static constexpr ReportMode DEFAULT_REPORT_MODE = REPORT_MODE_FIXED;
+
+static SpscQueue<ReportSnapshot, REPORT_QUEUE_SIZE> report_queue;
+
+// core0 側の状態
+static switch_report_t last_published;
+static bool     publish_pending = false;   // 前回キュー満杯で送れなかった
+static uint32_t pending_input_us = 0;
+static uint32_t pending_parsed_us = 0;
+static uint8_t  pending_source = TRACE_SRC_SYSTEM;
+static uint8_t  pending_fields = 0;        // report_mark_fields() で指定された項目
+static uint32_t queue_full = 0;            // キュー満杯で publish できなかった回数（リセットしない）
+
+// core1 側の状態（送信するレポート。プリセットもここを書き換える）
+static switch_report_t tx_report;
+static uint32_t tx_input_us = 0;           // 未送信の入力のうち最初の受信時刻
+static uint32_t tx_parsed_us = 0;          // 同、解析完了時刻
+static uint8_t  tx_source = TRACE_SRC_SYSTEM;  // tx_report を最後に変更した入力元
+static uint32_t last_send_us = 0;
+static bool     has_sent = false;
+static volatile bool tx_ready = false;
+
+// 変化時送信モード
+static switch_report_t last_sent_report;
+static bool     change_pending = false;    // 最後の送信以降に変化あり
+static uint32_t change_since_us = 0;       // 変化を検出した時刻
+static volatile ReportMode report_mode = DEFAULT_REPORT_MODE;
+static volatile uint32_t min_interval_us = 1000000 / REPORT_MAX_RATE_HZ;
+
+static ReportTxStats stats;                // core1 のみが書き込む
+static volatile bool stats_reset_requested = false;   // core0 → core1 のリセット要求
+
+// 送信統計のリセット（core1、または core1 の開始前に呼ぶ）
+static void reset_tx_stats(void) {
+  memset(&stats, 0, sizeof(stats));
+  has_sent = false;
+}
+
+void report_tx_begin(void) {
+  last_published = gp_report;
+  tx_report = gp_report;
+  last_sent_report = gp_report;
+  reset_tx_stats();
+  tx_ready = true;
+}
+
+void report_mark_input(uint32_t input_us, uint32_t parsed_us) {
+  if (pending_input_us == 0) {
+    pending_input_us = input_us;
+    pending_parsed_us = parsed_us;
+  }
+}
+
+void report_mark_source(uint8_t source) {
+  pending_source = source;
+}
+
+void report_mark_fields(uint8_t fields) {
+  pending_fields |= fields;
+}
+
+// 前回 publish した内容から変わった項目
+static uint8_t changed_fields(const switch_report_t* a, const switch_report_t* b) {
+  uint8_t fields = 0;
+  if (a->buttons != b->buttons) fields |= REPORT_FIELD_BUTTONS;
+  if (a->hat != b->hat) fields |= REPORT_FIELD_HAT;
+  if (a->lx != b->lx || a->ly != b->ly) fields |= REPORT_FIELD_LSTICK;
+  if (a->rx != b->rx || a->ry != b->ry) fields |= REPORT_FIELD_RSTICK;
+  if (a->vendor != b->vendor) fields |= REPORT_FIELD_VENDOR;
+  return fields;
+}
+
+bool report_publish(void) {
+  uint8_t fields = changed_fields(&last_published, &gp_report) | pending_fields;
+  if (!publish_pending && fields == 0) {
+    // 状態を変えなかった入力は、後の送信の遅延として数えない
+    pending_input_us = 0;
+    pending_source = TRACE_SRC_SYSTEM;
+    return true;
+  }
+  ReportSnapshot snap;
+  snap.report = gp_report;
+  snap.input_us = pending_input_us;
+  snap.parsed_us = pending_parsed_us;
+  snap.source = pending_source;
+  snap.fields = fields;
+  if (!report_queue.push(snap)) {
+    queue_full++;
+    publish_pending = true;
+    return false;
+  }
+  last_published = gp_report;
+  publish_pending = false;
+  pending_input_us = 0;
+  pending_source = TRACE_SRC_SYSTEM;
+  pending_fields = 0;
+  return true;
+}
+
+// 送信間隔を集計
+static void record_interval(uint32_t now_us) {
+  if (has_sent) {
+    uint32_t interval = now_us - last_send_us;
+    if (stats.sent == 1 || interval < stats.interval_min_us) stats.interval_min_us = interval;
+    if (interval > stats.interval_max_us) stats.interval_max_us = interval;
+    stats.interval_sum_us += interval;
+    stats.interval_sq_sum += (uint64_t)interval * interval;
+  }
+  last_send_us = now_us;
+  has_sent = true;
+  stats.sent++;
+}
+
+// レポート送信（成功時 true）
+static bool send_tx_report(uint32_t now) {
+  if (!usb_gamepad.ready()) {
+    stats.skipped_not_ready++;
+    return false;
+  }
+  usb_gamepad.sendReport(0, &tx_report, sizeof(tx_report));
+  trace_gamepad(tx_source, &tx_report);
+  last_sent_report = tx_report;
+  record_interval(now);
+  if (tx_input_us != 0) {
+    uint32_t sent_us = micros();
+    bench_record_report_latency(sent_us - tx_input_us);
+    latency_record(LAT_NEWLINE_TO_SEND, sent_us - tx_input_us);
+    latency_record(LAT_PARSED_TO_SEND, sent_us - tx_parsed_us);
+    tx_input_us = 0;
+  }
+  return true;
+}
+
+// キューから取り出したスナップショットを送信内容に反映（遅延は最初の未送信入力から数える）
+// core0 が書いた項目だけを上書きし、スティック指定のない行などでプリセット（OP_LSTICK）や
+// モーションが core1 で設定したスティックを core0 の古い値へ戻さない
+static void take_snapshot(const ReportSnapshot* snap) {
+  const switch_report_t* r = &snap->report;
+  if (snap->fields & REPORT_FIELD_BUTTONS) tx_report.buttons = r->buttons;
+  if (snap->fields & REPORT_FIELD_HAT) tx_report.hat = r->hat;
+  if (snap->fields & REPORT_FIELD_LSTICK) {
+    tx_report.lx = r->lx;
+    tx_report.ly = r->ly;
+  }
+  if (snap->fields & REPORT_FIELD_RSTICK) {
+    tx_report.rx = r->rx;
+    tx_report.ry = r->ry;
+  }
+  if (snap->fields & REPORT_FIELD_VENDOR) tx_report.vendor = r->vendor;
+  tx_source = snap->source;
+  if (snap->input_us != 0 && tx_input_us == 0) {
+    tx_input_us = snap->input_us;
+    tx_parsed_us = snap->parsed_us;
+  }
+}
+
+// 変化検出（最後に送信した内容との比較）
+static void detect_change(uint32_t now) {
+  if (!change_pending && memcmp(&tx_report, &last_sent_report, sizeof(tx_report)) != 0) {
+    change_pending = true;
+    change_since_us = now;
+  }
+}
+
+void report_tx_task(void) {
+  if (!tx_ready) return;
+  if (stats_reset_requested) {
+    reset_tx_stats();
+    stats_reset_requested = false;
+  }
+  latency_core1_poll();
+  bool mounted = TinyUSBDevice.mounted();
+  ReportSnapshot snap;
+
+  if (report_mode == REPORT_MODE_FIXED) {
+    // PC 側の更新を反映（最新のスナップショットが優先）
+    while (report_queue.pop(&snap)) take_snapshot(&snap);
+
+    // プリセット状態更新
+    LOOP_PROF_MARK(PROF_SEND);
+    if (update_preset_state(&tx_report)) tx_source = TRACE_SRC_PRESET;
+    if (replay_update(&tx_report)) tx_source = TRACE_SRC_REPLAY;
+    if (timeline_update(&tx_report)) tx_source = TRACE_SRC_TIMELINE;
+    if (motion_update(&tx_report)) tx_source = TRACE_SRC_MOTION;
+    LOOP_PROF_MARK(PROF_PRESET);
+
+    uint32_t now = micros();
+    if (!has_sent || now - last_send_us >= GAMEPAD_REPORT_INTERVAL_US) {
+      if (!mounted || !send_tx_report(now)) {
+        // 送信できない間も間隔の基準は進める
+        last_send_us = now;
+      }
+    }
+    return;
+  }
+
+  // 変化時送信モード: 未送信の変化がなければ次のスナップショットを1つ取り出す
+  // 最大レートで待たされている間に届いたものは最新の1つまで読み捨てる
+  // （古い状態を順に送って遅れが積み重ならないように）
+  uint32_t now = micros();
+  if (!change_pending) {
+    if (report_queue.pop(&snap)) take_snapshot(&snap);
+  } else if (has_sent && now - last_send_us < min_interval_us) {
+    bool drained = false;
+    while (report_queue.pop(&snap)) {
+      take_snapshot(&snap);
+      drained = true;
+    }
+    if (drained && memcmp(&tx_report, &last_sent_report, sizeof(tx_report)) == 0) {
+      // 最新の状態が送信済みの内容に戻った
+      change_pending = false;
+      tx_input_us = 0;
+    }
+  }
+  detect_change(now);
+
+  LOOP_PROF_MARK(PROF_SEND);
+  if (update_preset_state(&tx_report)) tx_source = TRACE_SRC_PRESET;
+  if (replay_update(&tx_report)) tx_source = TRACE_SRC_REPLAY;
+  if (timeline_update(&tx_report)) tx_source = TRACE_SRC_TIMELINE;
+  if (motion_update(&tx_report)) tx_source = TRACE_SRC_MOTION;
+  LOOP_PROF_MARK(PROF_PRESET);
+  detect_change(now);
+
+  if (!mounted) return;
+
+  uint32_t since_last = now - last_send_us;
+  if (change_pending && (!has_sent || since_last >= min_interval_us)) {
+    if (send_tx_report(now)) {
+      uint32_t latency = micros() - change_since_us;
+      stats.sent_on_change++;
+      stats.change_count++;
+      stats.change_sum_us += latency;
+      if (latency > stats.change_max_us) stats.change_max_us = latency;
+      change_pending = false;
+    }
+  } else if (!has_sent || since_last >= GAMEPAD_REPORT_INTERVAL_US) {
+    // キープアライブ
+    send_tx_report(now);
+  }
+}
+
+void report_tx_set_mode(ReportMode mode, uint32_t max_rate_hz) {
+  if (max_rate_hz < 1) max_rate_hz = 1;
+  if (max_rate_hz > REPORT_MAX_RATE_HZ) max_rate_hz = REPORT_MAX_RATE_HZ;
+  min_interval_us = 1000000 / max_rate_hz;
+  report_mode = mode;
+}
+
+ReportMode report_tx_get_mode(uint32_t* max_rate_hz) {
+  if (max_rate_hz) *max_rate_hz = 1000000 / min_interval_us;
+  return report_mode;
+}
+
+void report_tx_get_stats(ReportTxStats* out) {
+  *out = stats;
+  out->queue_full = queue_full;
+}
+
+// core1 が書き込み中の統計を core0 から消さないよう、次の report_tx_task でリセットさせる
+void report_tx_reset_stats(void) {
+  stats_reset_requested = true;
+}
@@ -0,0 +1,99 @@
+/**
+ * ReportTx.h - Gamepad レポート送信（core1）
+ * v1.6.0: USB HID 送信とプリセットのタイミング処理を core1 へ分離
+ *
+ * core0 はコマンド解析などで gp_report を更新し、report_publish() で
+ * スナップショットをキューへ送る。core1 は report_tx_task() でキューを
+ * 取り出し、プリセットを進めて一定間隔で送信する。
+ * ENABLE_DUAL_CORE が 0 の場合は core0 の loop() から report_tx_task() を呼ぶ。
+ */
+
+#ifndef REPORTTX_H
+#define REPORTTX_H
+
+#include <Arduino.h>
+#include "Common.h"
+
+#ifndef ENABLE_DUAL_CORE
+#define ENABLE_DUAL_CORE 1
+#endif
+
+// コア間キューの段数（2のべき乗）
+#define REPORT_QUEUE_SIZE 32
+
+// スナップショットで core0 が書いた項目（core1 はこの項目だけを送信内容へ反映する）
+#define REPORT_FIELD_BUTTONS  0x01
+#define REPORT_FIELD_HAT      0x02
+#define REPORT_FIELD_LSTICK   0x04
+#define REPORT_FIELD_RSTICK   0x08
+#define REPORT_FIELD_VENDOR   0x10
+
+// コア間で受け渡すレポートのスナップショット
+typedef struct {
+  switch_report_t report;
+  uint32_t        input_us;   // 元になった入力の受信時刻（0: 入力由来でない）
+  uint32_t        parsed_us;  // 同、解析完了時刻
+  uint8_t         source;     // 入力元（TraceSource）
+  uint8_t         fields;     // REPORT_FIELD_* の組み合わせ
+} ReportSnapshot;
+
+// 送信モード
+typedef enum {
+  REPORT_MODE_FIXED,          // 一定間隔（8ms）で送信（従来動作）
+  REPORT_MODE_ON_CHANGE,      // 変化時に即送信（最大レートで制限）＋キープアライブ
+} ReportMode;
+
+// 送信間隔の統計
+typedef struct {
+  uint32_t sent;              // 送信回数
+  uint32_t sent_on_change;    // うち変化による送信
+  uint32_t skipped_not_ready; // usb_gamepad.ready() が false で送れなかった回数
+  uint32_t change_count;      // 変化→送信 の遅延集計
+  uint64_t change_sum_us;
+  uint32_t change_max_us;
+  uint32_t interval_min_us;
+  uint32_t interval_max_us;
+  uint64_t interval_sum_us;
+  uint64_t interval_sq_sum;   // 分散計算用（us^2）
+  uint32_t queue_full;        // キュー満杯で publish できなかった回数
+} ReportTxStats;
+
+// 初期化（setup() の最後に呼ぶ。以降 core1 が送信を開始する）
+void report_tx_begin(void);
+
+// core0: 次の publish に入力の受信時刻と解析完了時刻を付ける
+// （publish で状態が変化しなかった場合は破棄される）
+void report_mark_input(uint32_t input_us, uint32_t parsed_us);
+
+// core0: 次の publish の入力元を指定（トレース記録用。未指定は TRACE_SRC_SYSTEM）
+void report_mark_source(uint8_t source);
+
+// core0: 次の publish で、値が前回と同じでも core1 へ反映する項目を指定
+// （PC の入力が明示的に書いた項目。core1 のプリセットなどが変えた値を上書きする）
+void report_mark_fields(uint8_t fields);
+
+// PC の入力（apply_gamepad_input() の raw_btns）が書く項目
+static inline uint8_t report_input_fields(uint16_t raw_btns) {
+  uint8_t fields = REPORT_FIELD_BUTTONS | REPORT_FIELD_HAT;
+  if (raw_btns & 0x01) fields |= REPORT_FIELD_RSTICK;   // bit0: 右スティック
+  if (raw_btns & 0x02) fields |= REPORT_FIELD_LSTICK;   // bit1: 左スティック
+  return fields;
+}
+
+// core0: gp_report が前回から変化した、または report_mark_fields() で項目が
+// 指定されていればスナップショットを送る
+bool report_publish(void);
+
+// core1: キュー処理・プリセット更新・レポート送信
+void report_tx_task(void);
+
+// 送信モード設定（max_rate_hz: 変化時送信の最大レート 1～1000Hz）
+void report_tx_set_mode(ReportMode mode, uint32_t max_rate_hz);
+ReportMode report_tx_get_mode(uint32_t* max_rate_hz);
+
+// 統計取得・リセット
+// リセットは要求のみで、core1 が次の report_tx_task の先頭で行う（queue_full は残す）
+void report_tx_get_stats(ReportTxStats* stats);
+void report_tx_reset_stats(void);
+
+#endif // REPORTTX_H
@@ -0,0 +1,58 @@
+/**
+ * SpscQueue.h - コア間受け渡し用のロックフリー単一生産者・単一消費者キュー
+ * v1.6.0: core0（生産者）→ core1（消費者）のレポート受け渡しに使用
+ */
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <Arduino.h>
+#include <atomic>
+
+/**
+ * 固定長リングバッファ（N は2のべき乗）
+ * push() は生産者コアのみ、pop()/peek() は消費者コアのみが呼ぶこと
+ */
+template <typename T, uint32_t N>
+class SpscQueue {
+  static_assert((N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+public:
+  bool push(const T& item) {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= N) return false;
+    buf_[head & (N - 1)] = item;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T* item) {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (head_.load(std::memory_order_acquire) == tail) return false;
+    *item = buf_[tail & (N - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // 先頭要素を取り出さずに参照（なければ nullptr）
+  const T* peek(void) const {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (head_.load(std::memory_order_acquire) == tail) return nullptr;
+    return &buf_[tail & (N - 1)];
+  }
+
+  uint32_t size(void) const {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+
+  uint32_t free_slots(void) const {
+    return N - size();
+  }
+
+private:
+  T buf_[N];
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+};
+
+#endif // SPSCQUEUE_H
@@ -0,0 +1,158 @@
+/**
+ * StickMath.h - スティック値の固定小数点計算（コンパイル時生成の正弦表）
+ * v1.6.0: FPU のない RP2040 で double の sin/cos と毎回の除算を避けるため追加
+ *
+ * 表は constexpr で生成し Flash に置く。実行時は表引きと整数演算のみ。
+ * - percent_to_value(): 従来の式と全入力で同じ値
+ * - stick_tilt_deg():   tiltLeftStick の従来の double 計算と -360～360 度・0.1% 刻みで同じ値
+ *                       （範囲外は従来版が円周率の丸めで 1 ずれる角度があり、本関数の方が正確）
+ *                       0.1% 刻みにないパワーは 0.1% 単位に丸めるため、従来版と最大 1 の差
+ * - stick_polar():      角度を 1/65536 周単位で受け取る補間版（正確な値の四捨五入と最大 1 の差）
+ */
+
+#ifndef STICKMATH_H
+#define STICKMATH_H
+
+#include <Arduino.h>
+#include "Common.h"
+
+// 1周 = 65536 の角度（0 = 上、時計回り）
+#define STICK_ANGLE_TURN     65536u
+#define STICK_SIN_Q          15      // stick_sin() の固定小数点桁数
+#define STICK_DEG_SIN_Q      30      // 1度刻みの表の固定小数点桁数（表は 32bit、積は 64bit）
+#define STICK_POWER_FULL     1000    // stick_tilt_deg() のパワーの単位（0.1%、1000 = 100%）
+
+// 従来の tiltLeftStick と同じ円周率（表を同じ値から作るため）
+#define STICK_LEGACY_PI      3.14159265
+
+// |x| <= π/2 の正弦（テイラー展開、コンパイル時のみ使用）
+constexpr double stick_sin_series(double x) {
+  double term = x, sum = x;
+  for (int n = 1; n < 16; n++) {
+    term *= -x * x / ((2 * n) * (2 * n + 1));
+    sum += term;
+  }
+  return sum;
+}
+
+template <typename T, size_t N>
+struct StickTable {
+  T v[N];
+};
+
+// 0～100% → スティック値（従来の式をそのまま評価）
+constexpr StickTable<uint8_t, 201> make_stick_percent_table() {
+  StickTable<uint8_t, 201> t{};
+  for (int p = -100; p <= 100; p++) {
+    t.v[p + 100] = (uint8_t)(STICK_CENTER + (p * 127 / 100));
+  }
+  return t;
+}
+
+// sin(0～90度) を Q30 で（切り捨て。従来版の (int) 変換と丸め方向を合わせる）
+constexpr StickTable<uint32_t, 91> make_stick_degree_table() {
+  StickTable<uint32_t, 91> t{};
+  for (int d = 0; d <= 90; d++) {
+    t.v[d] = (uint32_t)(stick_sin_series(d * STICK_LEGACY_PI / 180.0) * (double)(1ull << STICK_DEG_SIN_Q));
+  }
+  return t;
+}
+
+// 1/4 周を 256 分割した正弦を Q15 で（四捨五入）
+constexpr StickTable<uint16_t, 257> make_stick_quarter_table() {
+  StickTable<uint16_t, 257> t{};
+  for (int i = 0; i <= 256; i++) {
+    double x = i * (3.14159265358979323846 / 2.0) / 256.0;
+    t.v[i] = (uint16_t)(stick_sin_series(x) * (double)(1u << STICK_SIN_Q) + 0.5);
+  }
+  return t;
+}
+
+// inline: 翻訳単位ごとに複製せず Flash に1つだけ置く
+inline constexpr auto stick_percent_table = make_stick_percent_table();
+inline constexpr auto stick_degree_table = make_stick_degree_table();
+inline constexpr auto stick_quarter_table = make_stick_quarter_table();
+
+static_assert(stick_percent_table.v[0] == 1 && stick_percent_table.v[100] == STICK_CENTER &&
+              stick_percent_table.v[200] == 255, "percent table mismatch");
+static_assert(stick_quarter_table.v[256] == (1u << STICK_SIN_Q), "sine table must reach 1.0");
+
+/**
+ * パーセント値をスティック値に変換
+ * v1.6.0: 表引きに変更（範囲外も従来の式と同じく 0 / 255 に飽和）
+ * @param percent -100 ~ 100
+ * @return 0 ~ 255（128が中央）
+ */
+static inline uint8_t percent_to_value(int percent) {
+  if (percent < -100) return STICK_MIN;
+  if (percent > 100) return STICK_MAX;
+  return stick_percent_table.v[percent + 100];
+}
+
+/**
+ * 整数角度の正弦（Q30、符号付き）
+ */
+static inline int32_t stick_sin_deg(int deg) {
+  deg %= 360;
+  if (deg < 0) deg += 360;
+  int r = deg % 90;
+  switch (deg / 90) {
+    case 0:  return (int32_t)stick_degree_table.v[r];
+    case 1:  return (int32_t)stick_degree_table.v[90 - r];
+    case 2:  return -(int32_t)stick_degree_table.v[r];
+    default: return -(int32_t)stick_degree_table.v[90 - r];
+  }
+}
+
+// sin * パワー(0.1%単位) * 127 を 0 方向に切り捨て（従来の (int) 変換と同じ）
+static inline int stick_scale_trunc(int32_t s, uint32_t power_permille) {
+  uint64_t m = (uint64_t)(uint32_t)(s < 0 ? -s : s) * (power_permille * 127u);
+  int v = (int)((uint32_t)(m >> STICK_DEG_SIN_Q) / STICK_POWER_FULL);
+  return s < 0 ? -v : v;
+}
+
+/**
+ * 角度（度、0 = 上、時計回り）とパワー（0～1000、0.1% 単位）からスティック値を求める
+ * tiltLeftStick の従来の計算（double の sin/cos）と同じ結果
+ */
+static inline void stick_tilt_deg(int deg, uint32_t power_permille, uint8_t* x, uint8_t* y) {
+  if (power_permille > STICK_POWER_FULL) power_permille = STICK_POWER_FULL;
+  int vx = STICK_CENTER + stick_scale_trunc(stick_sin_deg(deg), power_permille);
+  int vy = STICK_CENTER - stick_scale_trunc(stick_sin_deg(deg + 90), power_permille);   // Y軸は逆
+  *x = (uint8_t)(vx < STICK_MIN ? STICK_MIN : (vx > STICK_MAX ? STICK_MAX : vx));
+  *y = (uint8_t)(vy < STICK_MIN ? STICK_MIN : (vy > STICK_MAX ? STICK_MAX : vy));
+}
+
+/**
+ * 1/65536 周単位の角度の正弦（Q15、符号付き、表の間は線形補間）
+ */
+static inline int32_t stick_sin(uint16_t angle) {
+  uint32_t quadrant = angle >> 14;
+  uint32_t pos = angle & 0x3FFF;                  // 1/4 周内の位置（14bit）
+  if (quadrant & 1) pos = 0x4000 - pos;           // 2・4象限は折り返し
+  uint32_t i = pos >> 6;
+  uint32_t frac = pos & 0x3F;
+  int32_t v = stick_quarter_table.v[i];
+  if (frac != 0) {
+    v += ((int32_t)stick_quarter_table.v[i + 1] - v) * (int32_t)frac >> 6;
+  }
+  return (quadrant & 2) ? -v : v;
+}
+
+// sin * power% * 127 を四捨五入
+static inline int stick_scale_round(int32_t s, uint32_t power_percent) {
+  uint32_t m = (uint32_t)(s < 0 ? -s : s) * (power_percent * 127u);
+  int v = (int)((m + (50u << STICK_SIN_Q)) / (100u << STICK_SIN_Q));
+  return s < 0 ? -v : v;
+}
+
+/**
+ * 角度（1/65536 周、0 = 上、時計回り）と半径（0～100%）からスティック値を求める
+ */
+static inline void stick_polar(uint16_t angle, uint32_t power_percent, uint8_t* x, uint8_t* y) {
+  if (power_percent > 100) power_percent = 100;
+  *x = (uint8_t)(STICK_CENTER + stick_scale_round(stick_sin(angle), power_percent));
+  *y = (uint8_t)(STICK_CENTER - stick_scale_round(stick_sin((uint16_t)(angle + 0x4000)), power_percent));
+}
+
+#endif // STICKMATH_H
@@ -0,0 +1,178 @@
+/**
+ * Timeline.cpp - タイムライン実行の実装
+ */
+
+#include "Timeline.h"
+#include "SpscQueue.h"
+#include <pico/time.h>
+
+static SpscQueue<TimelineStep, TIMELINE_QUEUE_SIZE> steps;
+
+static const switch_report_t neutral_report = {
+  0, HAT_CENTER, STICK_CENTER, STICK_CENTER, STICK_CENTER, STICK_CENTER, 0
+};
+
+// core0 → core1 の要求
+typedef enum { TL_REQ_NONE = 0, TL_REQ_GO, TL_REQ_STOP } TimelineRequest;
+static volatile uint8_t s_request = TL_REQ_NONE;
+static volatile uint8_t s_gen = 0;   // core0 が tl stop で進める
+
+// core1 の状態
+static volatile bool s_running = false;
+static uint64_t s_origin_us = 0;
+static uint64_t s_planned_us = 0;    // 開始から最後に適用したステップまでの計画時間
+static volatile uint32_t s_steps = 0;
+static volatile uint32_t s_late_max_us = 0;
+static volatile uint32_t s_resyncs = 0;
+
+// ==========================================
+// 実行（core1）
+// ==========================================
+
+bool timeline_update(switch_report_t* report) {
+  bool changed = false;
+  uint8_t req = s_request;
+  if (req == TL_REQ_GO) {
+    s_origin_us = time_us_64();
+    s_planned_us = 0;
+    s_steps = 0;
+    s_late_max_us = 0;
+    s_resyncs = 0;
+    s_running = true;
+    s_request = TL_REQ_NONE;
+  } else if (req == TL_REQ_STOP) {
+    if (s_running) {
+      *report = neutral_report;
+      changed = true;
+    }
+    s_running = false;
+    s_request = TL_REQ_NONE;
+  }
+
+  uint8_t gen = s_gen;
+  uint64_t now = time_us_64();
+  const TimelineStep* st;
+  while ((st = steps.peek()) != nullptr) {
+    TimelineStep step = *st;
+    if (step.gen != gen) {
+      // tl stop より前に積まれたステップ
+      steps.pop(&step);
+      continue;
+    }
+    if (!s_running) break;
+
+    uint64_t deadline = s_origin_us + s_planned_us + step.delta_us;
+    if (now < deadline) break;
+    uint32_t late = (uint32_t)(now - deadline);
+    if (late > TIMELINE_RESYNC_US) {
+      // 間に合わなかった分は詰めず、以降の間隔を保つ
+      s_origin_us += late;
+      s_resyncs++;
+    } else if (late > s_late_max_us) {
+      s_late_max_us = late;
+    }
+    s_planned_us += step.delta_us;
+
+    apply_gamepad_input_to(report, step.raw_btns, step.hat, step.lx, step.ly, step.rx, step.ry);
+    steps.pop(&step);
+    s_steps++;
+    changed = true;
+  }
+  return changed;
+}
+
+// ==========================================
+// コマンド（core0）
+// ==========================================
+
+void timeline_stop(void) {
+  s_gen++;
+  s_request = TL_REQ_STOP;
+}
+
+void timeline_get_status(TimelineStatus* status) {
+  status->running = s_running || s_request == TL_REQ_GO;
+  status->queued = steps.size();
+  status->free = steps.free_slots();
+  status->steps = s_steps;
+  status->late_max_us = s_late_max_us;
+  status->resyncs = s_resyncs;
+}
+
+/**
+ * "<経過us> <btns> <hat> <lx> <ly> [rx ry]" を解析（HEX 部分は通常の行と同じ）
+ */
+static bool parse_step(char* p, TimelineStep* st) {
+  while (*p == ' ') p++;
+  char* end;
+  unsigned long delta = strtoul(p, &end, 10);
+  if (end == p || *end != ' ') return false;
+  p = end;
+  while (*p == ' ') p++;
+  if (*p == '\0') return false;
+
+  st->delta_us = (uint32_t)delta;
+  st->raw_btns = (uint16_t)strtoul(p, &p, 16);
+  while (*p == ' ') p++;
+  st->hat = (uint8_t)strtoul(p, &p, 16);
+  while (*p == ' ') p++;
+  st->lx = (uint8_t)strtoul(p, &p, 16);
+  while (*p == ' ') p++;
+  st->ly = (uint8_t)strtoul(p, &p, 16);
+  while (*p == ' ') p++;
+  st->rx = (uint8_t)strtoul(p, &p, 16);
+  while (*p == ' ') p++;
+  st->ry = (uint8_t)strtoul(p, &p, 16);
+  return true;
+}
+
+static void print_status(void) {
+  TimelineStatus st;
+  timeline_get_status(&st);
+  Serial.printf("TL: %s queued=%lu free=%lu steps=%lu late_max=%lu us resyncs=%lu\n",
+                st.running ? "running" : "idle", (unsigned long)st.queued,
+                (unsigned long)st.free, (unsigned long)st.steps,
+                (unsigned long)st.late_max_us, (unsigned long)st.resyncs);
+}
+
+// tl <経過us> <HEX>[,<経過us> <HEX>...] / tl go / tl stop / tl
+void parse_timeline_command(char* line) {
+  char* sub = line[2] == ' ' ? &line[3] : &line[2];
+  if (strcmp(sub, "go") == 0) {
+    s_request = TL_REQ_GO;
+    print_status();
+    return;
+  }
+  if (strcmp(sub, "stop") == 0) {
+    timeline_stop();
+    Serial.println("TL: stopped");
+    return;
+  }
+  if (sub[0] == '\0') {
+    print_status();
+    return;
+  }
+
+  // ',' 区切りで複数ステップ。積めた分だけ積み、空き数を返す
+  uint8_t gen = s_gen;
+  uint32_t added = 0;
+  char* seg = sub;
+  while (seg != nullptr) {
+    char* next = strchr(seg, ',');
+    if (next != nullptr) *next++ = '\0';
+    TimelineStep st;
+    if (!parse_step(seg, &st)) {
+      Serial.printf("Error: tl step %lu: <delta_us> <btns> <hat> <lx> <ly> [rx ry]\n",
+                    (unsigned long)added);
+      break;
+    }
+    st.gen = gen;
+    if (!steps.push(st)) {
+      Serial.printf("Error: tl queue full, step %lu dropped\n", (unsigned long)added);
+      break;
+    }
+    added++;
+    seg = next;
+  }
+  Serial.printf("TL: added=%lu free=%lu\n", (unsigned long)added, (unsigned long)steps.free_slots());
+}
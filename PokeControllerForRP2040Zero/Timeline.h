@@ -0,0 +1,47 @@
+/**
+ * Timeline.h - 時刻指定のレポート列をまとめて受け取り、本体の時計で実行
+ * v1.6.0: 1行ずつの送信では USB シリアルの揺らぎがそのまま入力タイミングに出るため追加
+ *
+ * PC は "tl" で前のステップからの経過時間（us）付きのレポートを固定長キューへ積み、
+ * core1 が絶対期限で順に適用する。PC は返される空き数を見て次の分を先に送る（ダブルバッファ）。
+ */
+
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <Arduino.h>
+#include "Common.h"
+
+#define TIMELINE_QUEUE_SIZE  128     // ステップ数（2のべき乗）
+#define TIMELINE_RESYNC_US   20000   // これ以上遅れたら基準を合わせ直す（キューが空になった場合など）
+
+// 1ステップ（HEX プロトコルの1行分 + 経過時間）
+typedef struct {
+  uint32_t delta_us;    // 前のステップ（最初は tl go）からの経過時間
+  uint16_t raw_btns;    // HEX プロトコルと同じ（bit0/1: スティック有効フラグ）
+  uint8_t  hat;
+  uint8_t  lx, ly, rx, ry;
+  uint8_t  gen;         // tl stop で進む世代（古い世代のステップは捨てる）
+} TimelineStep;
+
+typedef struct {
+  bool     running;
+  uint32_t queued;
+  uint32_t free;
+  uint32_t steps;         // 実行したステップ数
+  uint32_t late_max_us;   // 期限からの最大遅れ
+  uint32_t resyncs;       // 基準を合わせ直した回数（主にキューが空になった場合）
+} TimelineStatus;
+
+// core1: 期限に達したステップを適用。report を変更した場合 true
+bool timeline_update(switch_report_t* report);
+
+// core0: 停止してキューを破棄（'end' コマンドなど）
+void timeline_stop(void);
+
+void timeline_get_status(TimelineStatus* status);
+
+// "tl ..." コマンドを処理
+void parse_timeline_command(char* line);
+
+#endif // TIMELINE_H
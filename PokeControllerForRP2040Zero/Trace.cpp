@@ -0,0 +1,85 @@
+/**
+ * Trace.cpp - 送信レポート記録の実装
+ */
+
+#include "Trace.h"
+#include <hardware/sync.h>
+
+static TraceRecord records[TRACE_CAPACITY];
+static uint32_t head = 0;        // 次に書く位置（総数。& (CAPACITY-1) で添字）
+static uint32_t missed = 0;
+static volatile bool enabled = true;
+static volatile bool dumping = false;
+static spin_lock_t* trace_lock = nullptr;
+
+static_assert((TRACE_CAPACITY & (TRACE_CAPACITY - 1)) == 0, "TRACE_CAPACITY must be a power of two");
+
+void trace_begin(void) {
+  trace_lock = spin_lock_instance((unsigned)spin_lock_claim_unused(true));
+}
+
+static void trace_push(uint8_t kind, uint8_t source, const uint8_t data[7]) {
+  if (trace_lock == nullptr) return;
+  uint32_t t = micros();
+  uint32_t irq = spin_lock_blocking(trace_lock);
+  if (!enabled || dumping) {
+    missed++;
+  } else {
+    TraceRecord* r = &records[head & (TRACE_CAPACITY - 1)];
+    r->t_us = t;
+    r->tag = (uint8_t)((kind << 4) | (source & 0x0F));
+    memcpy(r->data, data, 7);
+    head++;
+  }
+  spin_unlock(trace_lock, irq);
+}
+
+void trace_gamepad(uint8_t source, const switch_report_t* report) {
+  uint8_t data[7] = {
+    (uint8_t)(report->buttons & 0xFF), (uint8_t)(report->buttons >> 8),
+    report->hat, report->lx, report->ly, report->rx, report->ry
+  };
+  trace_push(TRACE_KIND_GAMEPAD, source, data);
+}
+
+void trace_keyboard(uint8_t source, uint8_t modifier, const uint8_t keys[6]) {
+  uint8_t data[7] = { modifier, keys[0], keys[1], keys[2], keys[3], keys[4], keys[5] };
+  trace_push(TRACE_KIND_KEYBOARD, source, data);
+}
+
+void trace_set_enabled(bool on) {
+  enabled = on;
+}
+
+void trace_clear(void) {
+  uint32_t irq = spin_lock_blocking(trace_lock);
+  head = 0;
+  missed = 0;
+  spin_unlock(trace_lock, irq);
+}
+
+void trace_get_status(TraceStatus* status) {
+  uint32_t irq = spin_lock_blocking(trace_lock);
+  status->total = head;
+  status->count = head < TRACE_CAPACITY ? head : TRACE_CAPACITY;
+  status->missed = missed;
+  status->enabled = enabled;
+  spin_unlock(trace_lock, irq);
+}
+
+void trace_dump(void) {
+  // 出力中は記録を止め、バッファをそのまま送る（その間の送信は missed に数える）
+  uint32_t irq = spin_lock_blocking(trace_lock);
+  dumping = true;
+  uint32_t end = head;
+  spin_unlock(trace_lock, irq);
+
+  uint32_t count = end < TRACE_CAPACITY ? end : TRACE_CAPACITY;
+  Serial.printf("Trace: dump n=%lu size=%u\n", (unsigned long)count, (unsigned)sizeof(TraceRecord));
+  for (uint32_t i = end - count; i != end; i++) {
+    Serial.write((const uint8_t*)&records[i & (TRACE_CAPACITY - 1)], sizeof(TraceRecord));
+  }
+  Serial.println("Trace: end");
+
+  dumping = false;
+}
@@ -0,0 +1,67 @@
+/**
+ * Trace.h - 送信した HID レポートの記録（RAM リングバッファ）
+ * v1.6.0: 長時間の周回がずれたとき、Switch に実際に届いた内容と時刻を確認するため追加
+ *
+ * TinyUSB に渡した Gamepad / Keyboard レポートを1件12バイトで記録する。
+ * Gamepad は core1、Keyboard は core0 から書き込むため、ハードウェアスピンロックで保護する。
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+#include "Common.h"
+
+#define TRACE_CAPACITY 2048   // 件数（2のべき乗）。12バイト x 2048 = 24KB
+
+// 記録の種類（tag の上位4ビット）
+typedef enum {
+  TRACE_KIND_GAMEPAD = 0,
+  TRACE_KIND_KEYBOARD,
+} TraceKind;
+
+// 入力元（tag の下位4ビット）
+typedef enum {
+  TRACE_SRC_SYSTEM = 0,   // 切断・タイムアウトによるリセットなど
+  TRACE_SRC_HEX,          // PC からのテキスト行
+  TRACE_SRC_BINARY,       // PC からのバイナリフレーム
+  TRACE_SRC_PRESET,       // プリセットのステップ
+  TRACE_SRC_API,          // 高レベルAPI
+  TRACE_SRC_KEYBOARD,     // キーストロークキュー
+  TRACE_SRC_REPLAY,       // 記録した入力の再生
+  TRACE_SRC_TIMELINE,     // タイムライン（tl）
+  TRACE_SRC_MOTION,       // スティック軌道（motion）
+} TraceSource;
+
+// 1件の記録（12バイト、リトルエンディアンでそのまま出力）
+typedef struct {
+  uint32_t t_us;          // 送信時刻（micros()）
+  uint8_t  tag;           // kind << 4 | source
+  uint8_t  data[7];       // Gamepad: buttons(LE16) hat lx ly rx ry / Keyboard: modifier keys[6]
+} TraceRecord;
+
+static_assert(sizeof(TraceRecord) == 12, "TraceRecord must stay 12 bytes");
+
+typedef struct {
+  uint32_t count;         // バッファ内の件数
+  uint32_t total;         // 記録した総数
+  uint32_t missed;        // 出力中・停止中で記録しなかった件数
+  bool     enabled;
+} TraceStatus;
+
+// 初期化（setup() で core1 起動前に呼ぶ）
+void trace_begin(void);
+
+// 記録（Gamepad は core1、Keyboard は core0 から呼ぶ）
+void trace_gamepad(uint8_t source, const switch_report_t* report);
+void trace_keyboard(uint8_t source, uint8_t modifier, const uint8_t keys[6]);
+
+void trace_set_enabled(bool enabled);
+void trace_clear(void);
+void trace_get_status(TraceStatus* status);
+
+// 古い順にバイナリで CDC へ出力
+// 形式: "Trace: dump n=<件数> size=12\n" + 件数 x 12 バイト + "Trace: end\n"
+void trace_dump(void);
+
+#endif // TRACE_H
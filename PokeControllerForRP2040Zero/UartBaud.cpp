@@ -0,0 +1,138 @@
+/**
+ * UartBaud.cpp - UART0 のボーレート切り替えの実装
+ */
+
+#include "UartBaud.h"
+#include "UartRx.h"
+
+static BaudState state = BAUD_STATE_DEFAULT;
+static uint32_t current_baud = UART_BAUD_DEFAULT;   // 要求したレート
+static uint32_t actual_baud = UART_BAUD_DEFAULT;    // 分周後の実際のレート
+static uint32_t probe_start_ms = 0;
+static uint32_t window_start_ms = 0;
+static uint32_t window_errors_base = 0;
+static uint32_t fallbacks = 0;
+
+// 監視対象の受信エラー数（行化けは line_errors、取りこぼしは overruns に出る）
+static uint32_t uart_error_count(void) {
+  UartRxStats st;
+  uart_rx_get_stats(&st);
+  return st.line_errors + st.overruns;
+}
+
+// CDC と UART の両方へ通知（UART 側は現在のレートで送られる）
+static void notify(const char* fmt, uint32_t a, uint32_t b) {
+  Serial.printf(fmt, (unsigned long)a, (unsigned long)b);
+  uart_tx.printf(fmt, (unsigned long)a, (unsigned long)b);
+}
+
+static void start_error_window(void) {
+  window_start_ms = millis();
+  window_errors_base = uart_error_count();
+}
+
+void uart_baud_begin(uint32_t baud) {
+  state = BAUD_STATE_DEFAULT;
+  current_baud = baud;
+  actual_baud = baud;
+}
+
+void uart_baud_fallback(const char* reason) {
+  if (state == BAUD_STATE_DEFAULT) return;
+  actual_baud = uart_rx_set_baud(UART_BAUD_DEFAULT);
+  current_baud = UART_BAUD_DEFAULT;
+  state = BAUD_STATE_DEFAULT;
+  fallbacks++;
+  Serial.printf("Baud: fallback to %lu (%s)\n", (unsigned long)current_baud, reason);
+  uart_tx.printf("Baud: fallback to %lu (%s)\n", (unsigned long)current_baud, reason);
+}
+
+void uart_baud_task(void) {
+  if (state == BAUD_STATE_PROBE) {
+    if (millis() - probe_start_ms > BAUD_CONFIRM_MS) uart_baud_fallback("no confirm");
+    return;
+  }
+  if (state == BAUD_STATE_FAST && millis() - window_start_ms >= BAUD_ERROR_WINDOW_MS) {
+    uint32_t errors = uart_error_count() - window_errors_base;
+    if (errors > BAUD_ERROR_LIMIT) {
+      uart_baud_fallback("rx errors");
+      return;
+    }
+    start_error_window();
+  }
+}
+
+static void print_status(void) {
+  static const char* const names[] = { "default", "probe", "fast" };
+  UartRxStats st;
+  uart_rx_get_stats(&st);
+  Serial.printf("Baud: %lu actual=%lu state=%s errors=%lu fallbacks=%lu\n",
+                (unsigned long)current_baud, (unsigned long)actual_baud, names[state],
+                (unsigned long)(st.line_errors + st.overruns), (unsigned long)fallbacks);
+}
+
+void parse_baud_command(const char* line, bool from_uart) {
+  const char* sub = line[4] == ' ' ? &line[5] : "";
+
+  if (sub[0] == '\0') {
+    print_status();
+    return;
+  }
+
+  if (strcmp(sub, "reset") == 0) {
+    uart_baud_fallback("reset");
+    print_status();
+    return;
+  }
+
+  if (strncmp(sub, "ok", 2) == 0 && (sub[2] == ' ' || sub[2] == '\0')) {
+    if (state != BAUD_STATE_PROBE || !from_uart) {
+      Serial.println("Error: baud ok is only accepted over UART after baud <rate>");
+      return;
+    }
+    const char* pattern = sub[2] == ' ' ? &sub[3] : "";
+    if (strcmp(pattern, BAUD_TEST_PATTERN) != 0) {
+      uart_baud_fallback("pattern mismatch");
+      return;
+    }
+    state = BAUD_STATE_FAST;
+    start_error_window();
+    notify("Baud: confirmed %lu actual=%lu\n", current_baud, actual_baud);
+    return;
+  }
+
+  char* end;
+  unsigned long baud = strtoul(sub, &end, 10);
+  if (end == sub || *end != '\0' || baud < UART_BAUD_MIN || baud > UART_BAUD_MAX) {
+    Serial.printf("Error: baud <%lu-%lu>|ok <pattern>|reset\n",
+                  (unsigned long)UART_BAUD_MIN, (unsigned long)UART_BAUD_MAX);
+    return;
+  }
+  if (state == BAUD_STATE_PROBE) {
+    Serial.println("Error: baud switch already in progress");
+    return;
+  }
+
+  // 旧レートで応答してから切り替える（PC はこの行を受け取ってからレートを変える）
+  notify("Baud: switch to %lu within %lu ms\n", (uint32_t)baud, BAUD_CONFIRM_MS);
+  uint32_t actual = uart_rx_set_baud((uint32_t)baud);
+  current_baud = (uint32_t)baud;
+  actual_baud = actual;
+
+  uint32_t diff = actual > baud ? actual - baud : (uint32_t)baud - actual;
+  if ((uint64_t)diff * 100 > (uint64_t)baud * UART_BAUD_TOLERANCE) {
+    // 分周で合わせられないレート: 確認を待たずに戻す
+    state = BAUD_STATE_PROBE;
+    uart_baud_fallback("divisor error");
+    return;
+  }
+
+  if (baud == UART_BAUD_DEFAULT) {
+    state = BAUD_STATE_DEFAULT;
+    return;
+  }
+
+  state = BAUD_STATE_PROBE;
+  probe_start_ms = millis();
+  uart_tx.print("BaudTest: " BAUD_TEST_PATTERN "\n");
+}
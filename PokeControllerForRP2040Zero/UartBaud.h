@@ -0,0 +1,50 @@
+/**
+ * UartBaud.h - UART0 のボーレート切り替え（ハンドシェイクと自動復帰）
+ * v1.6.0: 115200 bps（約 11 KB/s）では UART 接続の連続送信が CDC より大きく遅いため追加
+ *
+ * 1. PC が現在のレートで "baud <レート>" を送る
+ * 2. 基板は現在のレートで "Baud: switch ..." を返してから切り替え、
+ *    新しいレートで "BaudTest: <パターン>" を送る
+ * 3. PC は新しいレートで "baud ok <パターン>" を UART から送る
+ * BAUD_CONFIRM_MS 以内に正しいパターンが届かない場合や、
+ * 切り替え後に受信エラーが続いた場合は UART_BAUD_DEFAULT に戻す（"Baud: fallback ..." を送信）。
+ */
+
+#ifndef UARTBAUD_H
+#define UARTBAUD_H
+
+#include <Arduino.h>
+
+#define UART_BAUD_DEFAULT      115200    // 起動時・復帰先のレート
+#define UART_BAUD_MIN          9600
+#define UART_BAUD_MAX          3000000
+#define UART_BAUD_TOLERANCE    2         // 分周誤差の許容（%）
+#define BAUD_CONFIRM_MS        1000      // 切り替えから確認までの期限
+#define BAUD_ERROR_WINDOW_MS   1000      // 受信エラーを数える区間
+#define BAUD_ERROR_LIMIT       2         // 1区間でこれを超えたら復帰
+
+// 確認用パターン（0x55 の交互ビット、連続した 1/0 を含む。空白は含めない）
+#define BAUD_TEST_PATTERN      "UUUU****3333ffff~~~~!!!!0123456789ABCDEF"
+
+typedef enum {
+  BAUD_STATE_DEFAULT = 0,  // UART_BAUD_DEFAULT で動作中
+  BAUD_STATE_PROBE,        // 切り替え済み、PC からの確認待ち
+  BAUD_STATE_FAST          // 確認済み、受信エラーを監視中
+} BaudState;
+
+// 現在のレートで UART を開始したことを記録（uart_rx_begin の後に呼ぶ）
+void uart_baud_begin(uint32_t baud);
+
+// 確認期限と受信エラーの監視（loop() で毎回呼ぶ）
+void uart_baud_task(void);
+
+// 即座に UART_BAUD_DEFAULT へ戻す（reason は通知に含める）
+void uart_baud_fallback(const char* reason);
+
+/**
+ * "baud <レート>" / "baud ok <パターン>" / "baud reset" / "baud"（状態表示）
+ * @param from_uart 行を UART から受信した場合 true（確認は UART からのみ受け付ける）
+ */
+void parse_baud_command(const char* line, bool from_uart);
+
+#endif // UARTBAUD_H
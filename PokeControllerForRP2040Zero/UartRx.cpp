@@ -0,0 +1,316 @@
+/**
+ * UartRx.cpp - DMA リングバッファによる UART0 受信の実装
+ *
+ * データ用 DMA チャネルが UART0 の DR を読み、リングバッファへ書き込む。
+ * 転送数を使い切ると制御用チャネルが転送数を書き戻して再起動する（連続受信）。
+ * 読み出し側は DMA の書き込みアドレスを参照するだけで、割り込みは使わない。
+ */
+
+#include "UartRx.h"
+#include <hardware/uart.h>
+#include <hardware/dma.h>
+#include <hardware/gpio.h>
+
+#define RING_MASK (UART_RX_RING_SIZE - 1)
+
+// DMA リングラップのためバッファサイズ境界に配置する
+static uint8_t rx_ring[UART_RX_RING_SIZE] __attribute__((aligned(UART_RX_RING_SIZE)));
+
+// リングをまたいだ行・フレームのコピー先
+static char    line_linear[RX_LINE_MAX + 1];
+static uint8_t frame_buf[BIN_FRAME_SIZE];
+
+static int data_chan = -1;
+static int ctrl_chan = -1;
+static const uint32_t reload_count = 0xFFFFFFFFu;
+
+static uint32_t rd_pos = 0;        // 読み出し位置
+static uint32_t scan_pos = 0;      // 改行探索の再開位置（rd_pos からの距離）
+static uint32_t pending = 0;       // 前回返した単位のバイト数（次回解放）
+static uint32_t last_count = 0;    // 前回の DMA 残転送数
+static bool     discarding = false;
+
+// 到着時刻の記録: poll_dma で新しいバイトを検出するたびに、その時点の書き込み位置（通し番号）と時刻を残す
+// 行・フレームには、最後のバイトを初めて検出したポーリングの時刻を付ける
+// （実際の到着はその時刻と1つ前のポーリングの間。誤差は最大 loop() 1周）
+#define RX_MARK_COUNT 32
+typedef struct {
+  uint32_t end;    // この時刻までに届いたバイトの通し番号（末尾の次）
+  uint32_t t_us;
+} RxMark;
+static RxMark   marks[RX_MARK_COUNT];
+static uint8_t  mark_first = 0;
+static uint8_t  mark_count = 0;
+static uint32_t rd_abs = 0;        // rd_pos の通し番号
+static uint32_t wr_abs = 0;        // DMA 書き込み位置の通し番号
+static uint32_t last_head = 0;     // 前回の DMA 書き込み位置（リング内）
+
+static UartRxStats stats;
+
+void uart_rx_begin(int tx_pin, int rx_pin, uint32_t baud) {
+  uart_init(uart0, baud);
+  gpio_set_function(tx_pin, GPIO_FUNC_UART);
+  gpio_set_function(rx_pin, GPIO_FUNC_UART);
+
+  data_chan = dma_claim_unused_channel(true);
+  ctrl_chan = dma_claim_unused_channel(true);
+
+  // 制御チャネル: 転送数を書き戻し、データチャネルを再トリガー
+  dma_channel_config cc = dma_channel_get_default_config(ctrl_chan);
+  channel_config_set_transfer_data_size(&cc, DMA_SIZE_32);
+  channel_config_set_read_increment(&cc, false);
+  channel_config_set_write_increment(&cc, false);
+  dma_channel_configure(ctrl_chan, &cc,
+                        &dma_channel_hw_addr(data_chan)->al1_transfer_count_trig,
+                        &reload_count, 1, false);
+
+  // データチャネル: UART0 DR -> リング
+  dma_channel_config dc = dma_channel_get_default_config(data_chan);
+  channel_config_set_transfer_data_size(&dc, DMA_SIZE_8);
+  channel_config_set_read_increment(&dc, false);
+  channel_config_set_write_increment(&dc, true);
+  channel_config_set_ring(&dc, true, UART_RX_RING_BITS);
+  channel_config_set_dreq(&dc, uart_get_dreq(uart0, false));
+  channel_config_set_chain_to(&dc, ctrl_chan);
+
+  rd_pos = 0;
+  scan_pos = 0;
+  pending = 0;
+  discarding = false;
+  last_count = reload_count;
+  rd_abs = 0;
+  wr_abs = 0;
+  last_head = 0;
+  mark_count = 0;
+  memset(&stats, 0, sizeof(stats));
+
+  dma_channel_configure(data_chan, &dc, rx_ring, &uart_get_hw(uart0)->dr,
+                        reload_count, true);
+}
+
+// 新しく届いたバイトの範囲と検出時刻を記録
+static void push_mark(uint32_t end, uint32_t t_us) {
+  if (mark_count == RX_MARK_COUNT) {
+    // 満杯: 最も古い2つをまとめる（古い方の時刻を使い、遅延を小さく見積もらない側に寄せる。
+    // 1バイトずつ届く間も、直近の記録は正確なまま残る）
+    uint8_t second = (mark_first + 1) % RX_MARK_COUNT;
+    marks[second].t_us = marks[mark_first].t_us;
+    mark_first = second;
+    mark_count--;
+  }
+  marks[(mark_first + mark_count) % RX_MARK_COUNT] = {end, t_us};
+  mark_count++;
+}
+
+// 読み出し済みのバイトだけを含む記録を捨てる
+static void drop_marks(void) {
+  while (mark_count > 0 && (int32_t)(marks[mark_first].end - rd_abs) <= 0) {
+    mark_first = (mark_first + 1) % RX_MARK_COUNT;
+    mark_count--;
+  }
+}
+
+// rd_pos から offset バイト目を初めて検出した時刻
+static uint32_t arrival_us(uint32_t offset) {
+  uint32_t pos = rd_abs + offset;
+  for (uint8_t i = 0; i < mark_count; i++) {
+    const RxMark* m = &marks[(mark_first + i) % RX_MARK_COUNT];
+    if ((int32_t)(m->end - pos) > 0) return m->t_us;
+  }
+  return micros();
+}
+
+// DMA の進捗を反映し、未処理バイト数を返す
+static uint32_t poll_dma(void) {
+  dma_channel_hw_t* hw = dma_channel_hw_addr(data_chan);
+  uint32_t avail_before = (uint32_t)(stats.available);
+  uint32_t count = hw->transfer_count;
+  uint32_t head = (hw->write_addr - (uint32_t)(uintptr_t)rx_ring) & RING_MASK;
+  uint32_t received = last_count - count;  // 再起動時は最大1バイトの誤差（統計のみに影響）
+  last_count = count;
+  stats.bytes += received;
+  uint32_t moved = (head - last_head) & RING_MASK;
+  last_head = head;
+  if (moved > 0) {
+    wr_abs += moved;
+    push_mark(wr_abs, micros());
+  }
+
+  // 受信エラーは RSR に残る（DMA は DR の下位8ビットしか読まないため）
+  uart_hw_t* uhw = uart_get_hw(uart0);
+  if (uhw->rsr & (UART_UARTRSR_FE_BITS | UART_UARTRSR_PE_BITS |
+                  UART_UARTRSR_BE_BITS | UART_UARTRSR_OE_BITS)) {
+    stats.line_errors++;
+    uhw->rsr = 0;  // 書き込みでクリア
+  }
+
+  if (avail_before + received >= UART_RX_RING_SIZE) {
+    // 未処理データが上書きされた: 全て破棄し次の改行から再同期
+    stats.overruns++;
+    rd_pos = head;
+    rd_abs = wr_abs;
+    scan_pos = 0;
+    discarding = true;
+    mark_count = 0;
+  }
+
+  uint32_t avail = (head - rd_pos) & RING_MASK;
+  stats.available = avail;
+  if (avail > stats.high_water) stats.high_water = avail;
+  return avail;
+}
+
+static inline void advance(uint32_t n) {
+  rd_pos = (rd_pos + n) & RING_MASK;
+  rd_abs += n;
+  scan_pos = 0;
+  stats.available -= n;
+  drop_marks();
+}
+
+// rd_pos + scan_pos から avail までで改行を探す（見つからなければ -1）
+static int32_t find_newline(uint32_t avail) {
+  for (uint32_t i = scan_pos; i < avail; ) {
+    uint32_t pos = (rd_pos + i) & RING_MASK;
+    uint32_t chunk = UART_RX_RING_SIZE - pos;  // リング終端までの連続領域
+    if (chunk > avail - i) chunk = avail - i;
+    const uint8_t* base = &rx_ring[pos];
+    for (uint32_t j = 0; j < chunk; j++) {
+      if (base[j] == '\n' || base[j] == '\r') return (int32_t)(i + j);
+    }
+    i += chunk;
+  }
+  scan_pos = avail;
+  return -1;
+}
+
+bool uart_rx_next(RxItem* item) {
+  if (data_chan < 0) return false;
+
+  if (pending > 0) {
+    advance(pending);
+    pending = 0;
+  }
+
+  while (true) {
+    uint32_t avail = poll_dma();
+    if (avail == 0) return false;
+
+    if (discarding) {
+      int32_t nl = find_newline(avail);
+      if (nl < 0) {
+        advance(avail);
+        return false;
+      }
+      advance((uint32_t)nl + 1);
+      discarding = false;
+      continue;
+    }
+
+    uint8_t first = rx_ring[rd_pos];
+
+    // 空行（CRLF の片割れなど）
+    if (first == '\n' || first == '\r') {
+      advance(1);
+      continue;
+    }
+
+    // バイナリフレーム（行の先頭の SYNC のみ）
+    if (first == BIN_FRAME_SYNC) {
+      if (avail < 2) return false;
+      if (rx_ring[(rd_pos + 1) & RING_MASK] != BIN_FRAME_PAYLOAD_LEN) {
+        advance(1);  // 長さ不一致: SYNC を捨てて再同期
+        continue;
+      }
+      if (avail < BIN_FRAME_SIZE) return false;
+      for (uint32_t i = 0; i < BIN_FRAME_SIZE; i++) {
+        frame_buf[i] = rx_ring[(rd_pos + i) & RING_MASK];
+      }
+      item->kind = RX_ITEM_FRAME;
+      item->frame = frame_buf;
+      item->line = nullptr;
+      item->t_us = arrival_us(BIN_FRAME_SIZE - 1);
+      pending = BIN_FRAME_SIZE;
+      return true;
+    }
+
+    // テキスト行
+    int32_t nl = find_newline(avail);
+    if (nl < 0) {
+      if (avail > RX_LINE_MAX) {
+        stats.long_lines++;
+        discarding = true;
+        continue;
+      }
+      return false;
+    }
+    if ((uint32_t)nl > RX_LINE_MAX) {
+      stats.long_lines++;
+      advance((uint32_t)nl + 1);
+      continue;
+    }
+
+    uint32_t len = (uint32_t)nl;
+    if (rd_pos + len < UART_RX_RING_SIZE) {
+      // 連続領域: 改行を NUL に置き換えてリング内でそのまま解析
+      rx_ring[rd_pos + len] = '\0';
+      item->line = (char*)&rx_ring[rd_pos];
+    } else {
+      // リング終端をまたぐ（まれ）: 線形バッファへコピー
+      uint32_t first_part = UART_RX_RING_SIZE - rd_pos;
+      memcpy(line_linear, &rx_ring[rd_pos], first_part);
+      memcpy(&line_linear[first_part], rx_ring, len - first_part);
+      line_linear[len] = '\0';
+      item->line = line_linear;
+      stats.wrapped++;
+    }
+    item->kind = RX_ITEM_LINE;
+    item->frame = nullptr;
+    item->t_us = arrival_us(len);
+    pending = len + 1;
+    return true;
+  }
+}
+
+void uart_rx_get_stats(UartRxStats* out) {
+  *out = stats;
+}
+
+void uart_rx_reset_high_water(void) {
+  stats.high_water = stats.available;
+}
+
+uint32_t uart_rx_set_baud(uint32_t baud) {
+  uart_tx_wait_blocking(uart0);  // 送信中の応答を旧レートで送り切る
+  uint32_t actual = uart_set_baudrate(uart0, baud);
+
+  // 旧レートで受信した未処理のデータは捨てる（処理中の行も含め、以降は新レートのデータのみ）
+  if (data_chan >= 0) {
+    uint32_t avail = poll_dma();
+    if (pending > 0) {
+      advance(pending);
+      pending = 0;
+      avail = stats.available;
+    }
+    advance(avail);
+  }
+  uart_get_hw(uart0)->rsr = 0;
+  return actual;
+}
+
+uint32_t uart_rx_free(void) {
+  // 未処理 + 受信分がリングサイズに達すると上書き扱いになるため1バイト残す
+  return UART_RX_RING_SIZE - 1 - stats.available;
+}
+
+UartTx uart_tx;
+
+size_t UartTx::write(uint8_t c) {
+  uart_putc_raw(uart0, (char)c);
+  return 1;
+}
+
+size_t UartTx::write(const uint8_t* buf, size_t len) {
+  uart_write_blocking(uart0, buf, len);
+  return len;
+}
@@ -0,0 +1,53 @@
+/**
+ * UartRx.h - DMA リングバッファによる UART0 受信
+ * v1.6.0: Serial1 の1バイトずつの read() を置き換え、
+ *         ブロッキング処理中に届いたコマンドも取りこぼさないようにする
+ */
+
+#ifndef UARTRX_H
+#define UARTRX_H
+
+#include <Arduino.h>
+#include "LineAssembler.h"
+
+// リングバッファサイズ（2のべき乗。DMA のリングラップに使用）
+#define UART_RX_RING_BITS  12
+#define UART_RX_RING_SIZE  (1u << UART_RX_RING_BITS)
+
+// 受信統計
+typedef struct {
+  uint32_t bytes;        // 受信バイト数（累計）
+  uint32_t available;    // 未処理バイト数（現在値）
+  uint32_t high_water;   // 未処理バイト数の最大値
+  uint32_t overruns;     // DMA がリングを一周して未処理データを上書きした回数
+  uint32_t long_lines;   // RX_LINE_MAX 超過で破棄した行数
+  uint32_t wrapped;      // リング終端をまたいだためコピーした行数
+  uint32_t line_errors;  // v1.6.0: フレーミング/パリティ/ブレーク/FIFO オーバーランを検出した回数
+} UartRxStats;
+
+// UART0 と DMA を初期化して受信開始
+void uart_rx_begin(int tx_pin, int rx_pin, uint32_t baud);
+
+// 次の受信単位を取得（なければ false）
+// 取得した line/frame は次の uart_rx_next() 呼び出しまで有効
+bool uart_rx_next(RxItem* item);
+
+// 統計取得・HWMリセット
+void uart_rx_get_stats(UartRxStats* stats);
+void uart_rx_reset_high_water(void);
+
+// v1.6.0: ボーレートを変更（実際の値を返す）。受信済みの未処理データは破棄する
+uint32_t uart_rx_set_baud(uint32_t baud);
+
+// v1.6.0: リングの空き（上書きせずに受け取れるバイト数）
+uint32_t uart_rx_free(void);
+
+// v1.6.0: UART0 への送信（フロー制御の応答用。TX FIFO に空きがなければ待つ）
+class UartTx : public Print {
+public:
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buf, size_t len) override;
+};
+extern UartTx uart_tx;
+
+#endif // UARTRX_H
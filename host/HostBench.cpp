@@ -0,0 +1,555 @@
+/**
+ * HostBench.cpp - ホストシミュレーション上のベンチマーク
+ * v1.6.0: Switch を接続せずに、パース性能・改行→送信の遅延・プリセットの時間精度を計測
+ *
+ * 処理速度（ns/line など）はホスト CPU の実時間、遅延と時間精度は仮想時計で計測する。
+ * 仮想時計の結果は loop() 1周の所要時間（--loop-us）の仮定に依存する。
+ *
+ * HEX 行とバイナリフレーム（BinaryProtocol.h）は、処理速度と改行（フレーム末尾）→送信の遅延を並べて比較する。
+ *
+ * コマンド振り分けは、v1.5.0 の比較の連鎖（legacy_dispatch_route）と現在の表引きを同じ行の組で比較する。
+ * スティック計算は、v1.5.0 の tiltLeftStick の double 計算と StickMath.h の整数版の一致を全範囲で確認する。
+ * 最後にプリセットを押下中に止めてボタンが離されることを確認し、失敗したら終了コード 1 を返す。
+ *
+ * 使い方: host_bench [--loop-us N] [--lines N] [--preset-s N] [--echo]
+ */
+
+#include "HostSim.h"
+#include "Benchmark.h"
+#include "Presets.h"
+#include "BinaryProtocol.h"
+#include "StickMath.h"
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+// ==========================================
+// Benchmark.h の計測フック（実機版は Benchmark.cpp）
+// ==========================================
+
+extern ProcessState proc_state;   // Presets.cpp
+
+// プリセットのフェーズ期限（仮想時刻）
+static std::vector<uint64_t> preset_deadlines;
+static std::vector<uint32_t> preset_late;
+
+void bench_record_report_latency(uint32_t latency_us) {
+}
+
+void bench_record_preset_step(uint8_t preset, uint32_t late_us) {
+  preset_deadlines.push_back(sim_now_us() - late_us);
+  preset_late.push_back(late_us);
+}
+
+void run_benchmark(ProtocolParser parse, CommandMatcher match) {
+  Serial.println("Bench: host build (run host_bench)");
+}
+
+// ==========================================
+// 集計
+// ==========================================
+typedef struct {
+  size_t   n;
+  uint64_t min, avg, p50, p99, max;
+} Summary;
+
+static Summary summarize(std::vector<uint64_t> v) {
+  Summary s = {};
+  s.n = v.size();
+  if (v.empty()) return s;
+  std::sort(v.begin(), v.end());
+  uint64_t sum = 0;
+  for (uint64_t x : v) sum += x;
+  s.min = v.front();
+  s.max = v.back();
+  s.avg = sum / v.size();
+  s.p50 = v[(v.size() - 1) * 50 / 100];
+  s.p99 = v[(v.size() - 1) * 99 / 100];
+  return s;
+}
+
+static void print_summary(const char* label, const Summary& s) {
+  printf("Bench: %s n=%zu min=%llu avg=%llu p50=%llu p99=%llu max=%llu us\n", label, s.n,
+         (unsigned long long)s.min, (unsigned long long)s.avg, (unsigned long long)s.p50,
+         (unsigned long long)s.p99, (unsigned long long)s.max);
+}
+
+static uint64_t wall_ns(void) {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 再現性のある疑似乱数（送信間隔のばらつき用）
+static uint32_t rng_state = 12345;
+static uint32_t next_rand(void) {
+  rng_state = rng_state * 1103515245u + 12345u;
+  return rng_state >> 8;
+}
+
+// 基板へコマンドを送り、処理されるまで進める（出力は捨てる）
+static void send_command(const char* cmd) {
+  char line[64];
+  snprintf(line, sizeof(line), "%s\n", cmd);
+  sim_cdc_write(line);
+  sim_run_us(2000);
+  sim_take_cdc_output();
+}
+
+// ==========================================
+// 1. parse_protocol_line / バイナリフレームの処理速度
+// ==========================================
+static const GamepadInput bench_inputs[] = {
+  {0x0004, 0x08, 0x80, 0x80, 0x80, 0x80},
+  {0x0000, 0x08, 0x80, 0x80, 0x80, 0x80},
+  {0x0003, 0x08, 0x00, 0xFF, 0x80, 0x80},
+  {0x0002, 0x02, 0x80, 0x80, 0x80, 0x80},
+};
+static constexpr int BENCH_INPUT_COUNT = (int)(sizeof(bench_inputs) / sizeof(bench_inputs[0]));
+
+// HEX 行（改行なし）を生成し、改行を含むワイヤ上のバイト数を返す
+static size_t format_hex_line(const GamepadInput* in, char* line, size_t size) {
+  return snprintf(line, size, "%04X %02X %02X %02X %02X %02X",
+                  in->raw_btns, in->hat, in->lx, in->ly, in->rx, in->ry) + 1;
+}
+
+static void print_rate(const char* label, const char* unit, int iterations, uint64_t ns) {
+  if (ns == 0) ns = 1;
+  printf("Bench: %s %d %ss in %llu us (%llu %ss/s, %llu ns/%s, host CPU)\n", label, iterations, unit,
+         (unsigned long long)(ns / 1000), (unsigned long long)((uint64_t)iterations * 1000000000ULL / ns),
+         unit, (unsigned long long)(ns / iterations), unit);
+}
+
+static void bench_parse(int iterations) {
+  switch_report_t saved = gp_report;
+  char lines[BENCH_INPUT_COUNT][32];
+  uint8_t frames[BENCH_INPUT_COUNT][BIN_FRAME_SIZE];
+  size_t hex_bytes = 0;
+  for (int i = 0; i < BENCH_INPUT_COUNT; i++) {
+    hex_bytes += format_hex_line(&bench_inputs[i], lines[i], sizeof(lines[i]));
+    encode_binary_frame(&bench_inputs[i], frames[i]);
+  }
+
+  char work[32];
+  uint64_t start = wall_ns();
+  for (int i = 0; i < iterations; i++) {
+    strcpy(work, lines[i % BENCH_INPUT_COUNT]);
+    host_parse_protocol_line(work);
+  }
+  uint64_t hex_ns = wall_ns() - start;
+
+  start = wall_ns();
+  for (int i = 0; i < iterations; i++) {
+    GamepadInput in;
+    if (decode_binary_frame(frames[i % BENCH_INPUT_COUNT], &in)) {
+      apply_gamepad_input(in.raw_btns, in.hat, in.lx, in.ly, in.rx, in.ry);
+    }
+  }
+  uint64_t bin_ns = wall_ns() - start;
+  gp_report = saved;
+
+  print_rate("parse", "line", iterations, hex_ns);
+  print_rate("binary", "frame", iterations, bin_ns);
+  printf("Bench: bytes/update hex=%u binary=%u\n",
+         (unsigned)(hex_bytes / BENCH_INPUT_COUNT), (unsigned)BIN_FRAME_SIZE);
+}
+
+// ==========================================
+// 2. コマンド振り分け: v1.5.0 の比較の連鎖 と 表引き
+// ==========================================
+
+// HEX 行が大半、コマンド・プリセット・未知の単語を混ぜる（実機の bench と同じ組）
+static const char* const bench_command_mix[] = {
+  "0004 08 80 80 80 80",
+  "0000 08 80 80 80 80",
+  "0003 08 00 FF 80 80",
+  "0002 02 80 80 80 80",
+  "Key 28",
+  "Press 04",
+  "Release 04",
+  "end",
+  "mash_a",
+  "changetheyear",
+  "kbstat",
+  "api push A 100 1",
+  "report",
+  "my_preset",
+};
+static constexpr int BENCH_MIX_COUNT = (int)(sizeof(bench_command_mix) / sizeof(bench_command_mix[0]));
+
+static bool legacy_is_hex_char(char c) {
+  return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f');
+}
+
+// v1.5.0 の parse_preset_command（Presets.cpp）の比較部分
+static SimRoute legacy_parse_preset_command(const char* cmd, SimRoute route) {
+  if (strcmp(cmd, "mash_a") == 0) {
+    route = SIM_ROUTE_COMMAND;
+  }
+  else if (strcmp(cmd, "aaabb") == 0) {
+    route = SIM_ROUTE_COMMAND;
+  }
+  else if (strcmp(cmd, "auto_league") == 0) {
+    route = SIM_ROUTE_COMMAND;
+  }
+  else if (strcmp(cmd, "inf_watt") == 0) {
+    route = SIM_ROUTE_COMMAND;
+  }
+  else if (strcmp(cmd, "pickupberry") == 0) {
+    route = SIM_ROUTE_COMMAND;
+  }
+  else if (strcmp(cmd, "changethedate") == 0) {
+    route = SIM_ROUTE_COMMAND;
+  }
+  else if (strcmp(cmd, "changetheyear") == 0) {
+    route = SIM_ROUTE_COMMAND;
+  }
+  return route;
+}
+
+// v1.5.0 の parse_protocol_line（.ino）の判定部分。処理関数の呼び出しを振り分け先に置き換えた以外はそのまま
+static SimRoute legacy_dispatch_route(const char* line) {
+  SimRoute route = SIM_ROUTE_NONE;
+  if (strlen(line) < 1) return route;
+
+  if (!legacy_is_hex_char(line[0])) {
+    route = legacy_parse_preset_command(line, route);
+  }
+
+  if (line[0] == '"') {
+    return SIM_ROUTE_TYPE;
+  }
+
+  if (strncmp(line, "Key ", 4) == 0) {
+    return SIM_ROUTE_COMMAND;
+  }
+  if (strncmp(line, "Press ", 6) == 0) {
+    return SIM_ROUTE_COMMAND;
+  }
+  if (strncmp(line, "Release ", 8) == 0) {
+    return SIM_ROUTE_COMMAND;
+  }
+
+  if (strncmp(line, "end", 3) == 0) {
+    return SIM_ROUTE_COMMAND;
+  }
+
+  if (!legacy_is_hex_char(line[0])) return route;
+  return SIM_ROUTE_HEX;
+}
+
+static void bench_dispatch(int iterations) {
+  volatile int sink = 0;
+  uint64_t start = wall_ns();
+  for (int i = 0; i < iterations; i++) sink += host_dispatch_route(bench_command_mix[i % BENCH_MIX_COUNT]);
+  uint64_t table_ns = wall_ns() - start;
+
+  start = wall_ns();
+  for (int i = 0; i < iterations; i++) sink += legacy_dispatch_route(bench_command_mix[i % BENCH_MIX_COUNT]);
+  uint64_t chain_ns = wall_ns() - start;
+
+  printf("Bench: dispatch mix of %d table=%llu ns/line chain=%llu ns/line (host CPU)\n", BENCH_MIX_COUNT,
+         (unsigned long long)(table_ns / iterations), (unsigned long long)(chain_ns / iterations));
+
+  // 行ごとの比較（v1.5.0 で HEX と誤判定されていた名前、増えたコマンドが差として現れる）
+  for (int i = 0; i < BENCH_MIX_COUNT; i++) {
+    SimRoute now = host_dispatch_route(bench_command_mix[i]);
+    SimRoute old = legacy_dispatch_route(bench_command_mix[i]);
+    if (now == old) continue;
+    static const char* const route_names[] = { "none", "type", "command", "user_preset", "hex" };
+    printf("Bench: dispatch \"%s\" table=%s chain=%s\n", bench_command_mix[i], route_names[now], route_names[old]);
+  }
+}
+
+// ==========================================
+// 3. 改行（フレーム末尾）→Gamepad レポート送信の遅延
+// ==========================================
+
+// count 件を 5～25ms の間隔で送り、各入力を反映したレポートが送信されるまでの仮想時間を集計
+// binary: true ならバイナリフレーム、false なら HEX 行で送る
+// from_send: 送信開始（1バイト目の送出）からの時間。UART ではワイヤ上の転送時間を含む
+static Summary measure_newline_to_report(bool uart, bool binary, int count, Summary* from_send = nullptr) {
+  std::vector<uint64_t> latencies;
+  std::vector<uint64_t> send_latencies;
+  for (int i = 0; i < count; i++) {
+    sim_run_us(5000 + next_rand() % 20000);
+    uint16_t buttons = (i & 1) ? BUTTON_A : BUTTON_B;
+    GamepadInput in = {(uint16_t)(buttons << 2), 0x08, 0x80, 0x80, 0x80, 0x80};
+    uint8_t wire[32];
+    size_t len;
+    if (binary) {
+      encode_binary_frame(&in, wire);
+      len = BIN_FRAME_SIZE;
+    } else {
+      len = format_hex_line(&in, (char*)wire, sizeof(wire));
+      wire[len - 1] = '\n';
+    }
+
+    size_t first = sim_reports().size();
+    uint64_t send_us = sim_now_us();
+    uint64_t newline_us;
+    if (uart) {
+      newline_us = sim_uart_write(wire, len);
+    } else {
+      sim_cdc_write_bytes(wire, len);
+      newline_us = sim_now_us();
+    }
+
+    // 反映されたレポートが送信されるまで（最大 100ms）
+    uint64_t limit = newline_us + 100000;
+    bool found = false;
+    while (!found && sim_now_us() < limit) {
+      sim_step();
+      const std::vector<SimReport>& r = sim_reports();
+      for (size_t k = first; k < r.size(); k++) {
+        if (r[k].kind == SIM_REPORT_GAMEPAD && r[k].t_us >= newline_us && r[k].gamepad.buttons == buttons) {
+          latencies.push_back(r[k].t_us - newline_us);
+          send_latencies.push_back(r[k].t_us - send_us);
+          found = true;
+          break;
+        }
+      }
+    }
+    sim_clear_reports();
+  }
+  sim_take_cdc_output();
+  if (from_send) *from_send = summarize(send_latencies);
+  return summarize(latencies);
+}
+
+static void bench_latency(int count) {
+  static const char* const modes[] = { "report fixed", "report change 1000" };
+  for (const char* mode : modes) {
+    send_command(mode);
+    send_command("0000 08 80 80 80 80");
+    char label[64];
+    Summary hex_send, bin_send;
+    snprintf(label, sizeof(label), "newline->report cdc  [%s]", mode);
+    print_summary(label, measure_newline_to_report(false, false, count));
+    snprintf(label, sizeof(label), "newline->report uart [%s]", mode);
+    print_summary(label, measure_newline_to_report(true, false, count, &hex_send));
+    snprintf(label, sizeof(label), "frame->report   cdc  [%s]", mode);
+    print_summary(label, measure_newline_to_report(false, true, count));
+    snprintf(label, sizeof(label), "frame->report   uart [%s]", mode);
+    print_summary(label, measure_newline_to_report(true, true, count, &bin_send));
+    snprintf(label, sizeof(label), "send->report uart hex    [%s]", mode);
+    print_summary(label, hex_send);
+    snprintf(label, sizeof(label), "send->report uart binary [%s]", mode);
+    print_summary(label, bin_send);
+  }
+  send_command("report fixed");
+}
+
+// ==========================================
+// 4. プリセットの時間精度
+// ==========================================
+static const char* const preset_names[] = {
+  "mash_a", "aaabb", "auto_league", "inf_watt", "pickupberry", "changethedate", "changetheyear",
+};
+
+// 各フェーズの期限から、レポートの変化が USB に送信されるまでの時間
+// 次の期限までに送信内容が変わらなかったフェーズ（状態が同じ、または短すぎて送信されなかった）は unseen に数える
+static Summary edge_lag(uint32_t* unseen) {
+  std::vector<uint64_t> lags;
+  const std::vector<SimReport>& r = sim_reports();
+  *unseen = 0;
+  size_t k = 0;
+  switch_report_t prev = {0, HAT_CENTER, STICK_CENTER, STICK_CENTER, STICK_CENTER, STICK_CENTER, 0};
+  for (size_t i = 0; i < preset_deadlines.size(); i++) {
+    uint64_t d = preset_deadlines[i];
+    uint64_t next = (i + 1 < preset_deadlines.size()) ? preset_deadlines[i + 1] : UINT64_MAX;
+    for (; k < r.size() && r[k].t_us < d; k++) {
+      if (r[k].kind == SIM_REPORT_GAMEPAD) prev = r[k].gamepad;
+    }
+    size_t j = k;
+    while (j < r.size() && r[j].t_us <= next &&
+           (r[j].kind != SIM_REPORT_GAMEPAD || memcmp(&r[j].gamepad, &prev, sizeof(prev)) == 0)) {
+      j++;
+    }
+    if (j < r.size() && r[j].t_us <= next) {
+      lags.push_back(r[j].t_us - d);
+    } else {
+      (*unseen)++;
+    }
+  }
+  return summarize(lags);
+}
+
+static void bench_presets(uint32_t seconds) {
+  static const char* const modes[] = { "report fixed", "report change 1000" };
+  for (const char* mode : modes) {
+    send_command(mode);
+    printf("Bench: presets [%s] %lu s each\n", mode, (unsigned long)seconds);
+    for (const char* name : preset_names) {
+      send_command("end");
+      sim_run_us(100000);
+      preset_deadlines.clear();
+      preset_late.clear();
+      sim_clear_reports();
+
+      sim_cdc_write(name);
+      sim_cdc_write("\n");
+      uint64_t end = sim_now_us() + (uint64_t)seconds * 1000000ULL;
+      while (sim_now_us() < end) {
+        sim_run_us(100000);
+        sim_take_cdc_output();
+        if (proc_state == PRESET_NONE) break;   // 終了したプリセット
+      }
+
+      PresetTimingStats st;
+      get_preset_timing(&st);
+      std::vector<uint64_t> late(preset_late.begin(), preset_late.end());
+      Summary ls = summarize(late);
+      uint32_t unseen;
+      Summary es = edge_lag(&unseen);
+      printf("Bench: preset %-13s steps=%lu drift=%lld us late avg=%llu max=%llu us "
+             "usb edge avg=%llu p99=%llu max=%llu us unseen=%lu\n",
+             name, (unsigned long)st.steps, (long long)(st.actual_us - st.planned_us),
+             (unsigned long long)ls.avg, (unsigned long long)ls.max,
+             (unsigned long long)es.avg, (unsigned long long)es.p99, (unsigned long long)es.max,
+             (unsigned long)unseen);
+    }
+  }
+  send_command("end");
+  send_command("report fixed");
+}
+
+// ==========================================
+// 5. スティック計算: v1.5.0 の double 計算 と 固定小数点版
+// ==========================================
+
+// v1.5.0 の tiltLeftStick（HighLevelAPI.cpp）の計算部分
+static void legacy_tilt(int direction_deg, double power, uint8_t* x, uint8_t* y) {
+  if (power > 1.0) power = 1.0;
+  if (power < 0.0) power = 0.0;
+
+  double rad = direction_deg * 3.14159265 / 180.0;
+
+  int lx = STICK_CENTER + (int)(sin(rad) * power * 127.0);
+  int ly = STICK_CENTER - (int)(cos(rad) * power * 127.0); // Y軸は逆
+
+  if (lx < STICK_MIN) lx = STICK_MIN;
+  if (lx > STICK_MAX) lx = STICK_MAX;
+  if (ly < STICK_MIN) ly = STICK_MIN;
+  if (ly > STICK_MAX) ly = STICK_MAX;
+
+  *x = (uint8_t)lx;
+  *y = (uint8_t)ly;
+}
+
+static void bench_stick(int samples) {
+  volatile uint32_t sink = 0;
+  uint8_t x, y, lx, ly;
+
+  uint64_t start = wall_ns();
+  for (int i = 0; i < samples; i++) {
+    legacy_tilt(i % 720 - 360, (i % 1001) / 1000.0, &x, &y);
+    sink += x + y;
+  }
+  uint64_t legacy_ns = wall_ns() - start;
+  start = wall_ns();
+  for (int i = 0; i < samples; i++) {
+    stick_tilt_deg(i % 720 - 360, (uint32_t)(i % 1001), &x, &y);
+    sink += x + y;
+  }
+  uint64_t fixed_ns = wall_ns() - start;
+  printf("Bench: stick tilt legacy=%llu fixed=%llu ns/conv (host CPU)\n",
+         (unsigned long long)(legacy_ns / samples), (unsigned long long)(fixed_ns / samples));
+
+  // -360～360度 x 0～100% を 0.1% 刻み（api lsdeg と tiltLeftStickPermille の範囲）
+  uint32_t checked = 0, mismatches = 0;
+  for (int p = -150; p <= 150; p++) {
+    int v = STICK_CENTER + (p * 127 / 100);
+    uint8_t legacy = (uint8_t)(v < STICK_MIN ? STICK_MIN : (v > STICK_MAX ? STICK_MAX : v));
+    checked++;
+    if (percent_to_value(p) != legacy) mismatches++;
+  }
+  for (int deg = -360; deg <= 360; deg++) {
+    for (int pm = 0; pm <= (int)STICK_POWER_FULL; pm++) {
+      legacy_tilt(deg, pm / 1000.0, &lx, &ly);
+      stick_tilt_deg(deg, (uint32_t)pm, &x, &y);
+      checked++;
+      if (x != lx || y != ly) mismatches++;
+    }
+  }
+  printf("Bench: stick tilt 0.1%% grid mismatches=%lu/%lu\n", (unsigned long)mismatches, (unsigned long)checked);
+
+  // 0.1% 刻みにないパワー（tiltLeftStick は 0.1% 単位に丸める）: 差は最大 1
+  uint32_t differ = 0;
+  int max_diff = 0;
+  for (int i = 0; i < samples; i++) {
+    int deg = (int)(next_rand() % 721) - 360;
+    double power = (next_rand() & 0xFFFFFF) / (double)0xFFFFFF;
+    legacy_tilt(deg, power, &lx, &ly);
+    stick_tilt_deg(deg, (uint32_t)(power * STICK_POWER_FULL + 0.5), &x, &y);
+    int d = std::max(abs((int)x - (int)lx), abs((int)y - (int)ly));
+    if (d != 0) differ++;
+    max_diff = std::max(max_diff, d);
+  }
+  printf("Bench: stick tilt arbitrary power differ=%lu/%d max_diff=%d\n",
+         (unsigned long)differ, samples, max_diff);
+}
+
+// ==========================================
+// 6. プリセットを押下中に止めたときのボタン解放
+// ==========================================
+
+// mash_a の A 押下がレポートに出た直後に preset stop を送り、以降のレポートが中立に戻ることを確認する
+static bool check_preset_stop(void) {
+  send_command("end");
+  sim_run_us(100000);
+  sim_clear_reports();
+
+  sim_cdc_write("mash_a\n");
+  bool pressed = false;
+  uint64_t limit = sim_now_us() + 200000;
+  while (!pressed && sim_now_us() < limit) {
+    sim_run_us(100);
+    const std::vector<SimReport>& r = sim_reports();
+    pressed = !r.empty() && r.back().kind == SIM_REPORT_GAMEPAD && r.back().gamepad.buttons != 0;
+  }
+  sim_cdc_write("preset stop\n");
+  sim_run_us(50000);
+  sim_take_cdc_output();
+
+  const std::vector<SimReport>& r = sim_reports();
+  bool released = false;
+  for (size_t i = r.size(); pressed && i > 0; i--) {
+    if (r[i - 1].kind != SIM_REPORT_GAMEPAD) continue;
+    released = r[i - 1].gamepad.buttons == 0;
+    break;
+  }
+  printf("Bench: preset stop during press: %s\n", released ? "released" : "FAILED (button held)");
+  send_command("end");
+  return released;
+}
+
+int main(int argc, char** argv) {
+  uint32_t loop_us = SIM_DEFAULT_LOOP_COST_US;
+  int lines = 200;
+  uint32_t preset_seconds = 10;
+  bool echo = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--loop-us") == 0 && i + 1 < argc) loop_us = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    else if (strcmp(argv[i], "--lines") == 0 && i + 1 < argc) lines = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--preset-s") == 0 && i + 1 < argc) preset_seconds = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    else if (strcmp(argv[i], "--echo") == 0) echo = true;
+    else {
+      fprintf(stderr, "usage: %s [--loop-us N] [--lines N] [--preset-s N] [--echo]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (loop_us == 0) loop_us = 1;
+
+  sim_set_echo(echo);
+  sim_begin(loop_us);
+  sim_run_us(10000);
+  sim_take_cdc_output();
+  printf("Bench: host simulation loop=%lu us\n", (unsigned long)loop_us);
+
+  bench_parse(200000);
+  bench_dispatch(1000000);
+  bench_stick(1000000);
+  bench_latency(lines);
+  bench_presets(preset_seconds);
+  return check_preset_stop() ? 0 : 1;
+}
@@ -0,0 +1,367 @@
+/**
+ * HostSim.cpp - ホストシミュレーションの実装（仮想時計と Arduino / TinyUSB / pico-sdk の代替）
+ */
+
+#include "HostSim.h"
+#include <Adafruit_TinyUSB.h>
+#include <LittleFS.h>
+#include <hardware/dma.h>
+#include <hardware/uart.h>
+#include <hardware/structs/systick.h>
+#include <pico/platform.h>
+#include <pico/time.h>
+#include <cstdarg>
+#include <deque>
+
+// スケッチ側（PokeControllerForRP2040Zero.ino）
+void setup(void);
+void loop(void);
+void setup1(void) __attribute__((weak));
+void loop1(void) __attribute__((weak));
+
+// ==========================================
+// 仮想時計
+// ==========================================
+static uint64_t now_us = 0;
+static uint32_t loop_cost_us = SIM_DEFAULT_LOOP_COST_US;
+static uint32_t cost_rng = 1;
+static unsigned current_core = 0;
+
+uint64_t sim_now_us(void) { return now_us; }
+void sim_advance_us(uint64_t us) { now_us += us; }
+
+unsigned long millis(void) { return (unsigned long)(uint32_t)(now_us / 1000); }
+unsigned long micros(void) { return (unsigned long)(uint32_t)now_us; }
+void delay(unsigned long ms) { now_us += (uint64_t)ms * 1000; }
+void delayMicroseconds(unsigned int us) { now_us += us; }
+void yield(void) {}
+uint64_t time_us_64(void) { return now_us; }
+unsigned get_core_num(void) { return current_core; }
+
+static systick_hw_t systick_regs;
+systick_hw_t* const systick_hw = &systick_regs;
+
+// ==========================================
+// Print / シリアル
+// ==========================================
+size_t Print::write(const uint8_t* buf, size_t len) {
+  size_t n = 0;
+  while (len--) n += write(*buf++);
+  return n;
+}
+
+size_t Print::print(int v) {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%d", v);
+  return print(buf);
+}
+
+size_t Print::printf(const char* fmt, ...) {
+  char buf[512];
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  if (n < 0) return 0;
+  return write((const uint8_t*)buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+}
+
+static std::deque<uint8_t> cdc_rx;
+static std::string cdc_out;
+static std::string serial1_out;
+static std::string uart_out;
+static bool echo_output = false;
+
+Adafruit_USBD_CDC Serial;
+SerialUART Serial1;
+
+size_t HostSerial::write(uint8_t c) {
+  if (this == &Serial) {
+    cdc_out += (char)c;
+    if (echo_output) fputc(c, stdout);
+  } else {
+    serial1_out += (char)c;
+  }
+  return 1;
+}
+
+size_t HostSerial::write(const uint8_t* buf, size_t len) {
+  for (size_t i = 0; i < len; i++) write(buf[i]);
+  return len;
+}
+
+int HostSerial::available(void) { return this == &Serial ? (int)cdc_rx.size() : 0; }
+
+int HostSerial::read(void) {
+  if (this != &Serial || cdc_rx.empty()) return -1;
+  uint8_t c = cdc_rx.front();
+  cdc_rx.pop_front();
+  return c;
+}
+
+int HostSerial::peek(void) { return (this == &Serial && !cdc_rx.empty()) ? cdc_rx.front() : -1; }
+
+size_t HostSerial::read(uint8_t* buf, size_t len) {
+  size_t n = 0;
+  while (n < len) {
+    int c = read();
+    if (c < 0) break;
+    buf[n++] = (uint8_t)c;
+  }
+  return n;
+}
+
+// ==========================================
+// TinyUSB（HID レポートの記録）
+// ==========================================
+Adafruit_USBD_Device TinyUSBDevice;
+static std::vector<SimReport> reports;
+extern Adafruit_USBD_HID usb_gamepad;
+
+bool Adafruit_USBD_HID::ready(void) {
+  return TinyUSBDevice.mounted() && (!sent_ || (uint32_t)now_us - last_send_us_ >= USB_POLL_INTERVAL_US);
+}
+
+bool Adafruit_USBD_HID::sendReport(uint8_t report_id, const void* report, uint8_t len) {
+  if (!ready()) return false;
+  sent_ = true;
+  last_send_us_ = (uint32_t)now_us;
+  SimReport r = {};
+  r.t_us = now_us;
+  r.kind = (this == &usb_gamepad) ? SIM_REPORT_GAMEPAD : SIM_REPORT_KEYBOARD;
+  if (r.kind == SIM_REPORT_GAMEPAD) {
+    memcpy(&r.gamepad, report, len < sizeof(r.gamepad) ? len : sizeof(r.gamepad));
+  }
+  reports.push_back(r);
+  return true;
+}
+
+bool Adafruit_USBD_HID::keyboardReport(uint8_t report_id, uint8_t modifier, uint8_t keycode[6]) {
+  if (!ready()) return false;
+  sent_ = true;
+  last_send_us_ = (uint32_t)now_us;
+  SimReport r = {};
+  r.t_us = now_us;
+  r.kind = SIM_REPORT_KEYBOARD;
+  r.modifier = modifier;
+  memcpy(r.keys, keycode, sizeof(r.keys));
+  reports.push_back(r);
+  return true;
+}
+
+bool Adafruit_USBD_HID::keyboardRelease(uint8_t report_id) {
+  uint8_t none[6] = {0, 0, 0, 0, 0, 0};
+  return keyboardReport(report_id, 0, none);
+}
+
+const std::vector<SimReport>& sim_reports(void) { return reports; }
+void sim_clear_reports(void) { reports.clear(); }
+
+// ==========================================
+// LittleFS（メモリ上）
+// ==========================================
+FS LittleFS;
+
+size_t File::write(const uint8_t* buf, size_t len) {
+  if (!data_ || !writing_) return 0;
+  data_->insert(data_->end(), buf, buf + len);
+  return len;
+}
+
+int File::read(uint8_t* buf, size_t len) {
+  if (!data_) return -1;
+  size_t n = data_->size() - pos_;
+  if (n > len) n = len;
+  memcpy(buf, data_->data() + pos_, n);
+  pos_ += n;
+  return (int)n;
+}
+
+File FS::open(const char* path, const char* mode) {
+  if (mode[0] == 'w') {
+    HostFileData data = std::make_shared<std::vector<uint8_t>>();
+    files_[path] = data;
+    return File(data, true);
+  }
+  auto it = files_.find(path);
+  if (it == files_.end()) return File();
+  return File(it->second, false);
+}
+
+bool FS::exists(const char* path) {
+  return files_.count(path) > 0 || dirs_.count(path) > 0;
+}
+
+Dir FS::openDir(const char* path) {
+  std::string prefix = std::string(path) + "/";
+  std::vector<std::pair<std::string, HostFileData>> entries;
+  for (const auto& f : files_) {
+    if (f.first.compare(0, prefix.size(), prefix) == 0) {
+      entries.push_back({f.first.substr(prefix.size()), f.second});
+    }
+  }
+  return Dir(entries);
+}
+
+// ==========================================
+// UART0 と DMA（受信リングへの書き込み）
+// ==========================================
+struct uart_inst {
+  uart_hw_t hw;
+  uint32_t  baud;
+};
+static uart_inst uart0_inst = {};
+uart_inst_t* const uart0 = &uart0_inst;
+
+#define SIM_DMA_CHANNELS 4
+
+typedef struct {
+  dma_channel_hw_t hw;
+  uint8_t*  ring;        // 書き込み先の先頭（リング時）
+  uint32_t  ring_size;
+  uint32_t  pos;
+  bool      uart_rx;     // UART0 DR を読むチャネル
+} SimDmaChannel;
+
+static SimDmaChannel dma_channels[SIM_DMA_CHANNELS];
+static int dma_claimed = 0;
+
+typedef struct {
+  uint64_t t_us;
+  uint8_t  c;
+} WireByte;
+static std::deque<WireByte> uart_wire;
+static uint64_t uart_wire_free_us = 0;   // 次のバイトを送り始められる時刻
+static uint32_t wire_baud = 115200;
+
+// 到着時刻を過ぎたバイトを DMA のリングへ書き込む
+static void deliver_uart(void) {
+  SimDmaChannel* ch = nullptr;
+  for (int i = 0; i < dma_claimed; i++) {
+    if (dma_channels[i].uart_rx) ch = &dma_channels[i];
+  }
+  while (!uart_wire.empty() && uart_wire.front().t_us <= now_us) {
+    uint8_t c = uart_wire.front().c;
+    uart_wire.pop_front();
+    if (ch == nullptr || ch->ring == nullptr) continue;
+    if (uart0_inst.baud != wire_baud) {
+      uart0_inst.hw.rsr |= UART_UARTRSR_FE_BITS;   // レート不一致はフレーミングエラー扱い
+    }
+    ch->ring[ch->pos] = c;
+    ch->pos = (ch->pos + 1) & (ch->ring_size - 1);
+    ch->hw.write_addr = (uint32_t)(uintptr_t)(ch->ring + ch->pos);
+    ch->hw.transfer_count--;
+  }
+}
+
+int dma_claim_unused_channel(bool required) {
+  return dma_claimed < SIM_DMA_CHANNELS ? dma_claimed++ : -1;
+}
+
+dma_channel_config dma_channel_get_default_config(unsigned channel) {
+  dma_channel_config c = {};
+  return c;
+}
+
+void dma_channel_configure(unsigned channel, const dma_channel_config* config, volatile void* write_addr,
+                           const volatile void* read_addr, unsigned transfer_count, bool trigger) {
+  SimDmaChannel* ch = &dma_channels[channel];
+  ch->uart_rx = (read_addr == &uart0_inst.hw.dr);
+  ch->ring = config->ring_write ? (uint8_t*)write_addr : nullptr;
+  ch->ring_size = config->ring_write ? (1u << config->ring_bits) : 0;
+  ch->pos = 0;
+  ch->hw.write_addr = (uint32_t)(uintptr_t)write_addr;
+  ch->hw.transfer_count = transfer_count;
+}
+
+dma_channel_hw_t* dma_channel_hw_addr(unsigned channel) {
+  if (dma_channels[channel].uart_rx) deliver_uart();
+  return &dma_channels[channel].hw;
+}
+
+uart_hw_t* uart_get_hw(uart_inst_t* uart) { return &uart->hw; }
+
+unsigned uart_init(uart_inst_t* uart, unsigned baud) {
+  uart->baud = baud;
+  return baud;
+}
+
+unsigned uart_set_baudrate(uart_inst_t* uart, unsigned baud) {
+  uart->baud = baud;
+  return baud;
+}
+
+void uart_write_blocking(uart_inst_t* uart, const uint8_t* src, size_t len) {
+  uart_out.append((const char*)src, len);
+}
+
+// ==========================================
+// シミュレーション制御
+// ==========================================
+void sim_begin(uint32_t cost_us) {
+  now_us = 0;
+  loop_cost_us = cost_us;
+  cost_rng = 1;
+  setup();
+  if (setup1) {
+    current_core = 1;
+    setup1();
+    current_core = 0;
+  }
+}
+
+void sim_set_loop_cost_us(uint32_t us) { loop_cost_us = us; }
+
+void sim_step(void) {
+  loop();
+  if (loop1) {
+    current_core = 1;
+    loop1();
+    current_core = 0;
+  }
+  // 1周の時間は一定ではないため ±50% の幅を持たせる（期限が時計の刻みに揃わないように）
+  cost_rng = cost_rng * 1664525u + 1013904223u;
+  uint32_t half = loop_cost_us / 2;
+  now_us += loop_cost_us - half + (half > 0 ? (cost_rng >> 8) % (2 * half + 1) : 0);
+}
+
+void sim_run_us(uint64_t us) {
+  uint64_t end = now_us + us;
+  while (now_us < end) sim_step();
+}
+
+void sim_cdc_write(const char* s) {
+  sim_cdc_write_bytes((const uint8_t*)s, strlen(s));
+}
+
+void sim_cdc_write_bytes(const uint8_t* buf, size_t len) {
+  cdc_rx.insert(cdc_rx.end(), buf, buf + len);
+}
+
+uint64_t sim_uart_write(const uint8_t* buf, size_t len) {
+  // 1バイト = スタート + 8ビット + ストップ
+  uint64_t byte_ns = 10ULL * 1000000000ULL / wire_baud;
+  uint64_t t_ns = (uart_wire_free_us > now_us ? uart_wire_free_us : now_us) * 1000ULL;
+  for (size_t i = 0; i < len; i++) {
+    t_ns += byte_ns;
+    uart_wire.push_back({(t_ns + 999) / 1000, buf[i]});
+  }
+  uart_wire_free_us = (t_ns + 999) / 1000;
+  return uart_wire_free_us;
+}
+
+void sim_set_uart_baud(uint32_t baud) { wire_baud = baud; }
+
+std::string sim_take_cdc_output(void) {
+  std::string s;
+  s.swap(cdc_out);
+  return s;
+}
+
+std::string sim_take_uart_output(void) {
+  std::string s;
+  s.swap(uart_out);
+  return s;
+}
+
+void sim_set_echo(bool echo) { echo_output = echo; }
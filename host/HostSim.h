@@ -0,0 +1,103 @@
+/**
+ * HostSim.h - ファームウェアのホストシミュレーション（仮想時計・入出力の模擬）
+ * v1.6.0: Switch を接続せずにプリセットや PC 側の送信間隔を調整できるよう追加
+ *
+ * スケッチの setup() / loop() / loop1() をそのまま1スレッドで実行する。
+ * 時刻は仮想時計で、sim_step() 1回（loop() と loop1() を1回ずつ）ごとに
+ * loop_cost_us ± loop_cost_us/2 の範囲で（再現性のある疑似乱数で）進む。
+ * delay() はその場で時計を進める。
+ * - USB CDC: sim_cdc_write() で書いた行は、その時刻に全バイトが届いたものとして扱う
+ * - UART:    sim_uart_write() で書いたバイトは、ボーレートに従って1バイトずつリングへ届く
+ * - HID:     送信されたレポートを仮想時刻付きで記録する（sim_reports()）
+ */
+
+#ifndef HOSTSIM_H
+#define HOSTSIM_H
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+#include "Common.h"
+
+// 1回の sim_step() で進める時間の初期値（RP2040 の loop() 1周の目安）
+#define SIM_DEFAULT_LOOP_COST_US  20
+
+typedef enum {
+  SIM_REPORT_GAMEPAD,
+  SIM_REPORT_KEYBOARD,
+} SimReportKind;
+
+// 送信された HID レポート
+typedef struct {
+  uint64_t        t_us;
+  SimReportKind   kind;
+  switch_report_t gamepad;     // SIM_REPORT_GAMEPAD
+  uint8_t         modifier;    // SIM_REPORT_KEYBOARD
+  uint8_t         keys[6];
+} SimReport;
+
+// ==========================================
+// 仮想時計
+// ==========================================
+uint64_t sim_now_us(void);
+void sim_advance_us(uint64_t us);
+
+// ==========================================
+// シミュレーション制御
+// ==========================================
+
+// 仮想時計を 0 に戻し、setup() を実行する（プロセス内で1回）
+void sim_begin(uint32_t loop_cost_us);
+
+// loop() 1周の所要時間（仮想時計の進み）を変更
+void sim_set_loop_cost_us(uint32_t us);
+
+// loop() と loop1() を1回ずつ実行し、仮想時計を進める
+void sim_step(void);
+
+// 仮想時計で us 経過するまで sim_step() を繰り返す
+void sim_run_us(uint64_t us);
+
+// ==========================================
+// PC 側の入出力
+// ==========================================
+
+// USB CDC へ文字列を送る（改行は呼び出し側で付ける）
+void sim_cdc_write(const char* s);
+void sim_cdc_write_bytes(const uint8_t* buf, size_t len);
+
+// UART へバイト列を送る（前回の送信に続けてボーレートの間隔で届く）
+// 戻り値: 最後のバイトが届く仮想時刻
+uint64_t sim_uart_write(const uint8_t* buf, size_t len);
+void sim_set_uart_baud(uint32_t baud);
+
+// 基板が CDC / UART へ出力した内容（取り出すと空になる）
+std::string sim_take_cdc_output(void);
+std::string sim_take_uart_output(void);
+
+// true: 基板の CDC 出力を標準出力へも表示する
+void sim_set_echo(bool echo);
+
+// ==========================================
+// HID レポートの記録
+// ==========================================
+const std::vector<SimReport>& sim_reports(void);
+void sim_clear_reports(void);
+
+// ==========================================
+// スケッチの入口（SketchHost.cpp）
+// ==========================================
+void host_parse_protocol_line(char* line);
+
+// 行の振り分け先（コマンド振り分けの比較用）
+typedef enum {
+  SIM_ROUTE_NONE,          // 何もしない行
+  SIM_ROUTE_TYPE,          // 文字列タイピング
+  SIM_ROUTE_COMMAND,       // コマンド・組み込みプリセット
+  SIM_ROUTE_USER_PRESET,   // 保存プリセット
+  SIM_ROUTE_HEX,           // Gamepad プロトコル (HEX)
+} SimRoute;
+
+SimRoute host_dispatch_route(const char* line);
+
+#endif // HOSTSIM_H
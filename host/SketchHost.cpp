@@ -0,0 +1,21 @@
+/**
+ * SketchHost.cpp - スケッチ本体（PokeControllerForRP2040Zero.ino）をホストビルドへ取り込む
+ * v1.6.0: .ino は Arduino IDE と同じく C++ としてそのままコンパイルする
+ */
+
+#include "PokeControllerForRP2040Zero.ino"
+#include "HostSim.h"
+
+// ベンチマーク用: .ino 内の static 関数の入口
+void host_parse_protocol_line(char* line) {
+  parse_protocol_line(line);
+}
+
+// ベンチマーク用: parse_protocol_line と同じ順序で振り分け先だけを決める（処理関数は呼ばない）
+SimRoute host_dispatch_route(const char* line) {
+  if (line[0] == '\0') return SIM_ROUTE_NONE;
+  if (line[0] == '"') return SIM_ROUTE_TYPE;
+  if (command_lookup(command_table, line) != nullptr) return SIM_ROUTE_COMMAND;
+  if (strchr(line, ' ') == nullptr && preset_store_find(line) != nullptr) return SIM_ROUTE_USER_PRESET;
+  return is_hex_char(line[0]) ? SIM_ROUTE_HEX : SIM_ROUTE_NONE;
+}
@@ -0,0 +1,30 @@
+/**
+ * Adafruit_NeoPixel.h - ホストシミュレーション用の NeoPixel の代替（送信回数のみ数える）
+ */
+
+#ifndef HOST_ADAFRUIT_NEOPIXEL_H
+#define HOST_ADAFRUIT_NEOPIXEL_H
+
+#include <Arduino.h>
+
+#define NEO_GRB    0x52
+#define NEO_KHZ800 0x0000
+
+class Adafruit_NeoPixel {
+public:
+  Adafruit_NeoPixel(uint16_t n, int16_t pin, int type) {}
+  void begin(void) {}
+  void setBrightness(uint8_t b) {}
+  void setPixelColor(uint16_t n, uint32_t c) { color_ = c; }
+  void show(void) { shows_++; }
+  bool canShow(void) { return true; }
+  static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+    return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+  }
+
+private:
+  uint32_t color_ = 0;
+  uint32_t shows_ = 0;
+};
+
+#endif // HOST_ADAFRUIT_NEOPIXEL_H
@@ -0,0 +1,62 @@
+/**
+ * Adafruit_TinyUSB.h - ホストシミュレーション用の TinyUSB の代替
+ * v1.6.0: 送信した HID レポートを仮想時刻付きで HostSim に渡す
+ *
+ * ready() は前回の送信から USB_POLL_INTERVAL_US 経過するまで false を返す
+ * （setPollInterval(1) のフルスピード機器で、ホストが 1ms ごとに取りに来る動作を模擬）。
+ */
+
+#ifndef HOST_ADAFRUIT_TINYUSB_H
+#define HOST_ADAFRUIT_TINYUSB_H
+
+#include <Arduino.h>
+
+#define TU_ATTR_PACKED __attribute__((packed))
+#define TUD_HID_REPORT_DESC_KEYBOARD(...) 0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0xC0
+
+#define USB_POLL_INTERVAL_US 1000
+
+enum {
+  HID_KEY_A      = 0x04,
+  HID_KEY_1      = 0x1E,
+  HID_KEY_0      = 0x27,
+  HID_KEY_ENTER  = 0x28,
+  HID_KEY_SPACE  = 0x2C,
+  HID_KEY_MINUS  = 0x2D,
+  HID_KEY_PERIOD = 0x37,
+};
+
+class Adafruit_USBD_HID {
+public:
+  void setReportDescriptor(const uint8_t* desc, uint16_t len) {}
+  void setPollInterval(uint8_t ms) {}
+  bool begin(void) { return true; }
+  bool ready(void);
+  bool sendReport(uint8_t report_id, const void* report, uint8_t len);
+  bool keyboardReport(uint8_t report_id, uint8_t modifier, uint8_t keycode[6]);
+  bool keyboardRelease(uint8_t report_id);
+
+private:
+  bool     sent_ = false;
+  uint32_t last_send_us_ = 0;
+};
+
+class Adafruit_USBD_Device {
+public:
+  void detach(void) {}
+  void attach(void) { mounted_ = true; }
+  void setID(uint16_t vid, uint16_t pid) {}
+  void setManufacturerDescriptor(const char* s) {}
+  void setProductDescriptor(const char* s) {}
+  bool isInitialized(void) { return true; }
+  bool begin(uint8_t rhport = 0) { return true; }
+  bool mounted(void) { return mounted_; }
+  void setMounted(bool mounted) { mounted_ = mounted; }
+
+private:
+  bool mounted_ = false;
+};
+
+extern Adafruit_USBD_Device TinyUSBDevice;
+
+#endif // HOST_ADAFRUIT_TINYUSB_H
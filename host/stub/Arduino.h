@@ -0,0 +1,84 @@
+/**
+ * Arduino.h - ホストシミュレーション用の Arduino コアの代替
+ * v1.6.0: スケッチを Linux 上でビルドするため追加（arduino-pico の使用部分のみ）
+ *
+ * millis() / micros() / delay() は仮想時計（HostSim.cpp）で動作する。
+ * Serial（USB CDC）と Serial1 の入出力は HostSim.cpp で扱う。
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#define F_CPU 133000000L
+#define PIN_NEOPIXEL 16
+
+#define __not_in_flash_func(x) x
+#define __time_critical_func(x) x
+
+typedef uint8_t byte;
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buf, size_t len);
+  size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t print(const char* s) { return write(s); }
+  size_t print(int v);
+  size_t println(const char* s) { return print(s) + println(); }
+  size_t println(void) { return write((const uint8_t*)"\r\n", 2); }
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+  virtual int availableForWrite(void) { return 0; }
+  virtual void flush(void) {}
+};
+
+class Stream : public Print {
+public:
+  virtual int available(void) = 0;
+  virtual int read(void) = 0;
+  virtual int peek(void) = 0;
+};
+
+class HardwareSerial : public Stream {
+public:
+  virtual void begin(unsigned long baud) {}
+  virtual void end(void) {}
+  operator bool() { return true; }
+};
+
+// 受信バイト列を PC 側から書き込み、送信内容を記録するシリアルポート
+class HostSerial : public HardwareSerial {
+public:
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buf, size_t len) override;
+  int available(void) override;
+  int read(void) override;
+  int peek(void) override;
+  size_t read(uint8_t* buf, size_t len);
+  int availableForWrite(void) override { return 4096; }
+};
+
+class Adafruit_USBD_CDC : public HostSerial {};
+class SerialUART : public HostSerial {
+public:
+  bool setTX(int pin) { return true; }
+  bool setRX(int pin) { return true; }
+};
+
+extern Adafruit_USBD_CDC Serial;
+extern SerialUART Serial1;
+
+#endif // HOST_ARDUINO_H
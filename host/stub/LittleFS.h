@@ -0,0 +1,72 @@
+/**
+ * LittleFS.h - ホストシミュレーション用の LittleFS の代替（メモリ上のファイル）
+ */
+
+#ifndef HOST_LITTLEFS_H
+#define HOST_LITTLEFS_H
+
+#include <Arduino.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class String {
+public:
+  String(const std::string& s = "") : s_(s) {}
+  const char* c_str(void) const { return s_.c_str(); }
+  size_t length(void) const { return s_.size(); }
+
+private:
+  std::string s_;
+};
+
+typedef std::shared_ptr<std::vector<uint8_t>> HostFileData;
+
+class File {
+public:
+  File(void) {}
+  File(HostFileData data, bool writing) : data_(data), writing_(writing) {}
+  operator bool() const { return (bool)data_; }
+  size_t write(const uint8_t* buf, size_t len);
+  int read(uint8_t* buf, size_t len);
+  size_t size(void) { return data_ ? data_->size() : 0; }
+  void close(void) { data_.reset(); }
+
+private:
+  HostFileData data_;
+  bool   writing_ = false;
+  size_t pos_ = 0;
+};
+
+class Dir {
+public:
+  Dir(std::vector<std::pair<std::string, HostFileData>> entries = {}) : entries_(entries) {}
+  bool next(void) { return ++index_ < (int)entries_.size(); }
+  String fileName(void) { return String(entries_[index_].first); }
+  File openFile(const char* mode) { return File(entries_[index_].second, false); }
+  size_t fileSize(void) { return entries_[index_].second->size(); }
+
+private:
+  std::vector<std::pair<std::string, HostFileData>> entries_;
+  int index_ = -1;
+};
+
+class FS {
+public:
+  bool begin(void) { return true; }
+  bool format(void) { files_.clear(); return true; }
+  File open(const char* path, const char* mode);
+  bool exists(const char* path);
+  bool remove(const char* path) { return files_.erase(path) > 0; }
+  bool mkdir(const char* path) { dirs_[path] = true; return true; }
+  Dir openDir(const char* path);
+
+private:
+  std::map<std::string, HostFileData> files_;
+  std::map<std::string, bool> dirs_;
+};
+
+extern FS LittleFS;
+
+#endif // HOST_LITTLEFS_H
@@ -0,0 +1,45 @@
+/**
+ * hardware/dma.h - ホストシミュレーション用の DMA の代替
+ * UART の受信データは HostSim が DMA の書き込み先（リング）へ直接書き込む。
+ */
+
+#ifndef HOST_HARDWARE_DMA_H
+#define HOST_HARDWARE_DMA_H
+
+#include <stdint.h>
+
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+
+typedef struct {
+  uint8_t ring_bits;    // 0: リングなし
+  bool    ring_write;   // true: 書き込み側をラップ
+  bool    write_incr;
+} dma_channel_config;
+
+typedef struct {
+  volatile uint32_t read_addr;
+  volatile uint32_t write_addr;
+  volatile uint32_t transfer_count;
+  volatile uint32_t ctrl_trig;
+  volatile uint32_t al1_ctrl;
+  volatile uint32_t al1_read_addr;
+  volatile uint32_t al1_write_addr;
+  volatile uint32_t al1_transfer_count_trig;
+} dma_channel_hw_t;
+
+int dma_claim_unused_channel(bool required);
+dma_channel_config dma_channel_get_default_config(unsigned channel);
+static inline void channel_config_set_transfer_data_size(dma_channel_config* c, enum dma_channel_transfer_size size) {}
+static inline void channel_config_set_read_increment(dma_channel_config* c, bool incr) {}
+static inline void channel_config_set_write_increment(dma_channel_config* c, bool incr) { c->write_incr = incr; }
+static inline void channel_config_set_dreq(dma_channel_config* c, unsigned dreq) {}
+static inline void channel_config_set_ring(dma_channel_config* c, bool write, unsigned size_bits) {
+  c->ring_write = write;
+  c->ring_bits = (uint8_t)size_bits;
+}
+static inline void channel_config_set_chain_to(dma_channel_config* c, unsigned chain_to) {}
+void dma_channel_configure(unsigned channel, const dma_channel_config* config, volatile void* write_addr,
+                           const volatile void* read_addr, unsigned transfer_count, bool trigger);
+dma_channel_hw_t* dma_channel_hw_addr(unsigned channel);
+
+#endif // HOST_HARDWARE_DMA_H
@@ -0,0 +1,12 @@
+/**
+ * hardware/gpio.h - ホストシミュレーション用の GPIO の代替（何もしない）
+ */
+
+#ifndef HOST_HARDWARE_GPIO_H
+#define HOST_HARDWARE_GPIO_H
+
+enum gpio_function { GPIO_FUNC_UART = 2 };
+
+static inline void gpio_set_function(unsigned gpio, enum gpio_function fn) {}
+
+#endif // HOST_HARDWARE_GPIO_H
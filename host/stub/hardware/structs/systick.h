@@ -0,0 +1,20 @@
+/**
+ * hardware/structs/systick.h - ホストシミュレーション用の SysTick の代替
+ * ホストビルドでは ENABLE_LOOP_PROFILER=0 のため、宣言のみ。
+ */
+
+#ifndef HOST_HARDWARE_STRUCTS_SYSTICK_H
+#define HOST_HARDWARE_STRUCTS_SYSTICK_H
+
+#include <stdint.h>
+
+typedef struct {
+  volatile uint32_t csr;
+  volatile uint32_t rvr;
+  volatile uint32_t cvr;
+  volatile uint32_t calib;
+} systick_hw_t;
+
+extern systick_hw_t* const systick_hw;
+
+#endif // HOST_HARDWARE_STRUCTS_SYSTICK_H
@@ -0,0 +1,22 @@
+/**
+ * hardware/sync.h - ホストシミュレーション用のスピンロックの代替
+ * シミュレーションは core0 / core1 の処理を1スレッドで交互に実行するため、排他は不要。
+ */
+
+#ifndef HOST_HARDWARE_SYNC_H
+#define HOST_HARDWARE_SYNC_H
+
+#include <stdint.h>
+
+typedef volatile uint32_t spin_lock_t;
+
+static inline int spin_lock_claim_unused(bool required) { return 0; }
+static inline spin_lock_t* spin_lock_instance(unsigned lock_num) {
+  static spin_lock_t lock;
+  return &lock;
+}
+static inline uint32_t spin_lock_blocking(spin_lock_t* lock) { return 0; }
+static inline void spin_unlock(spin_lock_t* lock, uint32_t saved_irq) {}
+static inline void __dmb(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+
+#endif // HOST_HARDWARE_SYNC_H
@@ -0,0 +1,34 @@
+/**
+ * hardware/uart.h - ホストシミュレーション用の UART の代替
+ * 送信データは HostSim の UART 出力に記録する。
+ */
+
+#ifndef HOST_HARDWARE_UART_H
+#define HOST_HARDWARE_UART_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct {
+  volatile uint32_t dr;
+  volatile uint32_t rsr;
+  volatile uint32_t fr;
+} uart_hw_t;
+
+typedef struct uart_inst uart_inst_t;
+extern uart_inst_t* const uart0;
+
+#define UART_UARTRSR_FE_BITS 0x1u
+#define UART_UARTRSR_PE_BITS 0x2u
+#define UART_UARTRSR_BE_BITS 0x4u
+#define UART_UARTRSR_OE_BITS 0x8u
+
+uart_hw_t* uart_get_hw(uart_inst_t* uart);
+unsigned uart_init(uart_inst_t* uart, unsigned baud);
+unsigned uart_set_baudrate(uart_inst_t* uart, unsigned baud);
+static inline unsigned uart_get_dreq(uart_inst_t* uart, bool is_tx) { return 0; }
+void uart_write_blocking(uart_inst_t* uart, const uint8_t* src, size_t len);
+static inline void uart_putc_raw(uart_inst_t* uart, char c) { uart_write_blocking(uart, (const uint8_t*)&c, 1); }
+static inline void uart_tx_wait_blocking(uart_inst_t* uart) {}
+
+#endif // HOST_HARDWARE_UART_H
@@ -0,0 +1,13 @@
+/**
+ * hardware/watchdog.h - ホストシミュレーション用のウォッチドッグの代替（何もしない）
+ */
+
+#ifndef HOST_HARDWARE_WATCHDOG_H
+#define HOST_HARDWARE_WATCHDOG_H
+
+#include <stdint.h>
+
+static inline void watchdog_enable(uint32_t delay_ms, bool pause_on_debug) {}
+static inline void watchdog_update(void) {}
+
+#endif // HOST_HARDWARE_WATCHDOG_H
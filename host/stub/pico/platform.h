@@ -0,0 +1,13 @@
+/**
+ * pico/platform.h - ホストシミュレーション用の代替
+ */
+
+#ifndef HOST_PICO_PLATFORM_H
+#define HOST_PICO_PLATFORM_H
+
+#include <stdint.h>
+
+// 現在シミュレーション中のコア（HostSim が core1 の処理中だけ 1 にする）
+unsigned get_core_num(void);
+
+#endif // HOST_PICO_PLATFORM_H
@@ -0,0 +1,13 @@
+/**
+ * pico/time.h - ホストシミュレーション用の代替（仮想時計）
+ */
+
+#ifndef HOST_PICO_TIME_H
+#define HOST_PICO_TIME_H
+
+#include <stdint.h>
+
+uint64_t time_us_64(void);
+static inline uint32_t time_us_32(void) { return (uint32_t)time_us_64(); }
+
+#endif // HOST_PICO_TIME_H